@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include <array>
+#include "Config.h"
+
+// ===================== AoE の係数表（半径ごと） =====================
+// 中心からの距離 d、w = 1 - d / (r + 0.001) として
+//   塗り     … paintDelta * (0.5 + 0.5w)
+//   ダメージ … dmg * (0.6 + 0.4w)
+// を dx^2 + dy^2 <= r^2 のセルに当てる。行 dy の係数は rowStart[dy + r] から 2 * halfWidth + 1 個（dx = -halfWidth..）。
+struct AoeStamp {
+	int radius = 0;
+	s3d::Array<int> halfWidth;			// dy = -r..r
+	s3d::Array<int> rowStart;			// 各行の先頭（paintScale / damageScale の添字）
+	s3d::Array<float> paintScale;
+	s3d::Array<double> damageScale;
+
+	void build(int r) {
+		radius = r;
+		halfWidth.assign(2 * r + 1, 0);
+		rowStart.assign(2 * r + 1, 0);
+		paintScale.clear();
+		damageScale.clear();
+		for (int dy = -r; dy <= r; ++dy) {
+			int hw = 0;
+			while ((hw + 1) * (hw + 1) + dy * dy <= r * r) ++hw;
+			halfWidth[dy + r] = hw;
+			rowStart[dy + r] = (int)paintScale.size();
+			for (int dx = -hw; dx <= hw; ++dx) {
+				const double w = 1.0 - s3d::Sqrt((double)(dx * dx + dy * dy)) / (double)(r + 0.001);
+				paintScale << (float)(0.5 + 0.5 * w);
+				damageScale << (0.6 + 0.4 * w);
+			}
+		}
+	}
+};
+
+// 半径 r の係数表。AoeStampCacheRadius までは一度だけ作って使い回す（スレッド間で共有、読むだけ）
+// それより大きい半径はスレッドごとに1枚持ち、半径が変わったら作り直す
+inline const AoeStamp& GetAoeStamp(int r) {
+	if (r < 0) r = 0;
+	if (r <= AoeStampCacheRadius) {
+		static const std::array<AoeStamp, AoeStampCacheRadius + 1> cache = [] {
+			std::array<AoeStamp, AoeStampCacheRadius + 1> a;
+			for (int i = 0; i <= AoeStampCacheRadius; ++i) a[i].build(i);
+			return a;
+			}();
+		return cache[r];
+	}
+	static thread_local AoeStamp large;
+	if (large.radius != r || large.halfWidth.isEmpty()) large.build(r);
+	return large;
+}
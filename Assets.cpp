@@ -0,0 +1,142 @@
+﻿#include "Assets.h"
+
+using namespace s3d;
+
+namespace {
+	// ワーカーでの展開結果
+	template <class T>
+	struct Decoded {
+		T data;
+		double ms = 0.0;
+	};
+}
+
+struct AssetRegistry::TextureEntry {
+	AsyncTask<Decoded<Image>> task;
+	Texture texture;
+	size_t record = 0;
+};
+
+struct AssetRegistry::SoundEntry {
+	AsyncTask<Decoded<Wave>> task;
+	Audio audio;
+	size_t record = 0;
+};
+
+AssetRegistry::AssetRegistry() = default;
+
+// 展開中のものは AsyncTask のデストラクタが終わるまで待つ
+AssetRegistry::~AssetRegistry() = default;
+
+TextureHandle AssetRegistry::texture(FilePathView relUnderRom) {
+	const FilePath rel{ relUnderRom };
+	if (const auto it = m_textureIndex.find(rel); it != m_textureIndex.end()) return TextureHandle{ it->second };
+
+	auto e = std::make_unique<TextureEntry>();
+	e->record = m_records.size();
+	e->task = Async([path = RomPath(rel)] {
+		const Stopwatch sw{ StartImmediately::Yes };
+		Decoded<Image> d;
+		if (FileSystem::Exists(path)) d.data = Image{ path };
+		d.ms = sw.msF();
+		return d;
+		});
+	m_records << LoadRecord{ rel };
+	++m_pending;
+
+	const TextureHandle h{ (uint16)m_textures.size() };
+	m_textures.push_back(std::move(e));
+	m_textureIndex.emplace(rel, h.index);
+	return h;
+}
+
+SoundHandle AssetRegistry::sound(FilePathView relUnderRom) {
+	const FilePath rel{ relUnderRom };
+	if (const auto it = m_soundIndex.find(rel); it != m_soundIndex.end()) return SoundHandle{ it->second };
+
+	auto e = std::make_unique<SoundEntry>();
+	e->record = m_records.size();
+	e->task = Async([path = RomPath(rel)] {
+		const Stopwatch sw{ StartImmediately::Yes };
+		Decoded<Wave> d;
+		if (FileSystem::Exists(path)) d.data = Wave{ path };
+		d.ms = sw.msF();
+		return d;
+		});
+	m_records << LoadRecord{ rel };
+	++m_pending;
+
+	const SoundHandle h{ (uint16)m_sounds.size() };
+	m_sounds.push_back(std::move(e));
+	m_soundIndex.emplace(rel, h.index);
+	return h;
+}
+
+void AssetRegistry::update() {
+	if (m_pending == 0) return;
+	for (auto& e : m_textures) if (e->task.isValid() && e->task.isReady()) upload(*e);
+	for (auto& e : m_sounds) if (e->task.isValid() && e->task.isReady()) upload(*e);
+}
+
+void AssetRegistry::finishAll() {
+	if (m_pending == 0) return;
+	for (auto& e : m_textures) if (e->task.isValid()) upload(*e);
+	for (auto& e : m_sounds) if (e->task.isValid()) upload(*e);
+}
+
+const Texture& AssetRegistry::get(TextureHandle h) const {
+	static const Texture empty;
+	return ((h && h.index < m_textures.size()) ? m_textures[h.index]->texture : empty);
+}
+
+const Audio& AssetRegistry::get(SoundHandle h) const {
+	static const Audio empty;
+	return ((h && h.index < m_sounds.size()) ? m_sounds[h.index]->audio : empty);
+}
+
+// task.get() は終わっていなければ待つ
+void AssetRegistry::upload(TextureEntry& e) {
+	const Decoded<Image> d = e.task.get();
+	m_records[e.record].decodeMs = d.ms;
+	const Stopwatch sw{ StartImmediately::Yes };
+	if (d.data) e.texture = Texture{ d.data };
+	markReady(e.record, sw.msF(), (bool)e.texture);
+}
+
+void AssetRegistry::upload(SoundEntry& e) {
+	const Decoded<Wave> d = e.task.get();
+	m_records[e.record].decodeMs = d.ms;
+	const Stopwatch sw{ StartImmediately::Yes };
+	if (d.data) e.audio = Audio{ d.data };
+	markReady(e.record, sw.msF(), (bool)e.audio);
+}
+
+void AssetRegistry::markReady(size_t record, double uploadMs, bool ok) {
+	LoadRecord& r = m_records[record];
+	r.uploadMs = uploadMs;
+	r.readyAtMs = m_clock.msF();
+	r.ok = ok;
+	if (!ok) Logger << U"[assets] failed to load " << r.path;
+
+	if (--m_pending == 0) {
+		m_allReadyMs = r.readyAtMs;
+		Logger << U"[assets] " << summary();
+	}
+}
+
+String AssetRegistry::summary() const {
+	double decode = 0.0, upload = 0.0, slowest = 0.0;
+	size_t failed = 0;
+	FilePath slowestPath;
+	for (const auto& r : m_records) {
+		decode += r.decodeMs;
+		upload += r.uploadMs;
+		if (!r.ok) ++failed;
+		if (r.decodeMs > slowest) { slowest = r.decodeMs; slowestPath = r.path; }
+	}
+	String s = U"{} files / decode {:.1f} ms (slowest {} {:.1f} ms) / upload {:.1f} ms"_fmt(m_records.size(), decode, slowestPath, slowest, upload);
+	if (m_pending > 0) s += U" / {} pending"_fmt(m_pending);
+	else s += U" / ready at {:.1f} ms"_fmt(m_allReadyMs);
+	if (failed > 0) s += U" / {} failed"_fmt(failed);
+	return s;
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "RomPath.h"
+
+// ===================== アセット（テクスチャ・音声） =====================
+// 登録した時点でワーカースレッド（Async）がファイルを読み、Image / Wave まで展開しておく。
+// Texture / Audio を作るのはメインスレッドの update() / finishAll() だけ。
+// タイトル画面の間に毎フレーム update() を回しておけば、ゲーム開始時にはほぼ全部そろっている。
+// ハンドルは登録順の番号（コピーも比較も安い）。同じパスを登録し直すと同じハンドルが返る。
+struct TextureHandle {
+	uint16 index = 0xFFFF;
+	explicit operator bool() const noexcept { return (index != 0xFFFF); }
+};
+struct SoundHandle {
+	uint16 index = 0xFFFF;
+	explicit operator bool() const noexcept { return (index != 0xFFFF); }
+};
+
+class AssetRegistry {
+public:
+	// 1件ぶんの読み込み時間
+	struct LoadRecord {
+		s3d::FilePath path;		// Rom の下の相対パス
+		double decodeMs = 0.0;	// ワーカーでの読み込み・展開
+		double uploadMs = 0.0;	// メインスレッドで Texture / Audio にするまで
+		double readyAtMs = 0.0;	// レジストリを作ってから使えるようになるまで
+		bool ok = false;
+	};
+
+	AssetRegistry();
+	~AssetRegistry();
+
+	AssetRegistry(const AssetRegistry&) = delete;
+	AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+	// 登録して読み込みを始める（relUnderRom は "texture/T_sBasic.png" のような Rom の下の相対パス）
+	TextureHandle texture(s3d::FilePathView relUnderRom);
+	SoundHandle sound(s3d::FilePathView relUnderRom);
+
+	// 展開し終わったものを Texture / Audio にする（毎フレーム呼ぶ。待たない）
+	void update();
+
+	// 残りを全部待って Texture / Audio にする（ゲーム開始時）
+	void finishAll();
+
+	// まだそろっていなければ空の Texture / Audio を返す（待たない）
+	const s3d::Texture& get(TextureHandle h) const;
+	const s3d::Audio& get(SoundHandle h) const;
+
+	size_t pendingCount() const noexcept { return m_pending; }
+	bool isReady() const noexcept { return (m_pending == 0); }
+
+	// 読み込み時間（登録順。テクスチャ・音声の区別なし）
+	const s3d::Array<LoadRecord>& records() const noexcept { return m_records; }
+	// 全部そろったときの経過時間（そろっていなければ 0）
+	double allReadyMs() const noexcept { return m_allReadyMs; }
+	// 1行の要約（プロファイラの表示・ログ用）
+	s3d::String summary() const;
+
+private:
+	struct TextureEntry;
+	struct SoundEntry;
+
+	s3d::Array<std::unique_ptr<TextureEntry>> m_textures;
+	s3d::Array<std::unique_ptr<SoundEntry>> m_sounds;
+	s3d::HashTable<s3d::FilePath, uint16> m_textureIndex, m_soundIndex;
+	s3d::Array<LoadRecord> m_records;
+	s3d::Stopwatch m_clock{ s3d::StartImmediately::Yes };
+	size_t m_pending = 0;
+	double m_allReadyMs = 0.0;
+
+	void upload(TextureEntry& e);
+	void upload(SoundEntry& e);
+	void markReady(size_t record, double uploadMs, bool ok);
+};
@@ -0,0 +1,45 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "RomPath.h"
+
+// ===================== BGM =====================
+// BGM は全体を展開せず、Audio::Stream で少しずつ読みながら鳴らす（展開用のバッファは Siv3D が持つ小さなものだけ）。
+// はじめて play() したときに開き、別の曲に切り替えたら前の曲は閉じる。鳴っているのは常に1曲だけ。
+// 開けなかった曲も覚えておき、同じ曲では開き直さない（毎フレーム play() を呼んでよい）。
+class BgmPlayer {
+public:
+	BgmPlayer() = default;
+	BgmPlayer(const BgmPlayer&) = delete;
+	BgmPlayer& operator=(const BgmPlayer&) = delete;
+
+	// relUnderRom の曲をループ再生する（同じ曲が鳴っていれば何もしない）
+	void play(s3d::FilePathView relUnderRom, double volume) {
+		if (m_path != relUnderRom) {
+			stop();
+			m_path = s3d::FilePath{ relUnderRom };
+			const s3d::FilePath path = RomPath(relUnderRom);
+			if (s3d::FileSystem::Exists(path)) m_audio = s3d::Audio{ s3d::Audio::Stream, path };
+			if (m_audio) m_audio.setLoop(true);
+		}
+		if (m_audio && !m_audio.isPlaying()) {
+			m_audio.setVolume(volume);
+			m_audio.play();
+		}
+	}
+
+	// 止めて閉じる
+	void stop() {
+		if (m_audio) {
+			m_audio.stop();
+			m_audio.release();
+		}
+		m_audio = s3d::Audio{};
+		m_path.clear();
+	}
+
+	bool isPlaying() const { return (m_audio && m_audio.isPlaying()); }
+
+private:
+	s3d::FilePath m_path;	// 今の曲（Rom の下の相対パス）
+	s3d::Audio m_audio;
+};
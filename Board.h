@@ -1,24 +1,130 @@
 ﻿#pragma once
 #include <Siv3D.hpp>
+#include <bit>
 #include "Entities.h"
 #include "Config.h"
+#include "PaintKernel.h"
 
+// タイルは 16x16 のチャンク単位で並べる（近いセルが同じキャッシュ行に乗るように）
+// kind / paint / blueIndex / redIndex はすべて idx() で引くこと（y * w + x ではない）
+// 地形と塗りは別の配列にする（塗りの処理は毎回触るので、塗りだけを詰めて読めるように）
 struct Board {
-	s3d::Array<Tile> tiles;      // GW*GH
-	s3d::Array<int> blueIndex;   // 各セルの味方構造物インデックス（-1=なし）
-	s3d::Array<int> redIndex;    // 各セルの敵構造物インデックス（-1=なし）
-	s3d::RectF gridRect;
-	double tileSize = 32.0;
+	int w = 0, h = 0;				// 盤面の大きさ（タイル）
+	int chunksX = 0, chunksY = 0;	// チャンク数
 
-	void init() {
-		tiles.assign(GW * GH, Tile{});
-		blueIndex.assign(GW * GH, -1);
-		redIndex.assign(GW * GH, -1);
+	s3d::Array<TileKind> kind;   // 地形（チャンク順。端のチャンクは未使用の余りを含む）
+	s3d::Array<PaintValue> paint; // 塗り（0=Red、PaintMax=Blue。書くときは setPaint() / addPaintRun() を使う）
+	s3d::Array<StructureHandle> blueIndex;   // 各セルの味方構造物（StructureMap のハンドル。値 0 = なし）
+	s3d::Array<StructureHandle> redIndex;    // 各セルの敵構造物
+	s3d::Array<uint8> chunkDirty; // 塗り・地形が変わったチャンク（描画側が見て下ろす）
+	s3d::RectF gridRect;         // シミュレーション座標（画面への配置は Game 側の変換で行う）
+	double tileSize = SimTileSize;
+
+	// 支配タイル数（Blue: paint > PaintBlueOwned / Red: paint < PaintRedOwned）
+	int blueTiles = 0;
+	int redTiles = 0;
+
+	// 壁の配置が変わるたびに増える（経路・誘導場のキャッシュの鍵）
+	uint32 wallVersion = 0;
+
+	void init(int width, int height) {
+		w = width; h = height;
+		chunksX = ((w + BoardChunkSize - 1) >> BoardChunkShift);
+		chunksY = ((h + BoardChunkSize - 1) >> BoardChunkShift);
+		const size_t n = ((size_t)chunksX * chunksY) << (2 * BoardChunkShift);
+		kind.assign(n, TileKind::Floor);
+		paint.assign(n, PaintNeutral);
+		blueIndex.assign(n, StructureHandle{});
+		redIndex.assign(n, StructureHandle{});
+		chunkDirty.assign((size_t)chunksX * chunksY, 1);
+		tileSize = SimTileSize;
+		gridRect = s3d::RectF{ 0, 0, w * tileSize, h * tileSize };
+		++wallVersion;
+		recountOwnership();
+	}
+
+	inline int idx(int x, int y) const noexcept {
+		const int chunk = ((y >> BoardChunkShift) * chunksX + (x >> BoardChunkShift));
+		const int local = (((y & (BoardChunkSize - 1)) << BoardChunkShift) | (x & (BoardChunkSize - 1)));
+		return ((chunk << (2 * BoardChunkShift)) | local);
+	}
+	int cellCount() const noexcept { return (w * h); }
+	size_t tileCount() const noexcept { return kind.size(); }	// 配列の長さ（チャンクの余りを含む）
+
+	// 全セルをチャンク順に (x, y, idx) で回す
+	template <class Fn>
+	void forEachCell(Fn fn) const {
+		for (int cy = 0; cy < chunksY; ++cy) {
+			for (int cx = 0; cx < chunksX; ++cx) {
+				forEachCellInChunk(cx, cy, fn);
+			}
+		}
+	}
+	template <class Fn>
+	void forEachCellInChunk(int cx, int cy, Fn fn) const {
+		const int x0 = (cx << BoardChunkShift), y0 = (cy << BoardChunkShift);
+		const int x1 = s3d::Min(x0 + BoardChunkSize, w), y1 = s3d::Min(y0 + BoardChunkSize, h);
+		for (int y = y0; y < y1; ++y) {
+			int i = idx(x0, y);
+			for (int x = x0; x < x1; ++x, ++i) fn(x, y, i);
+		}
+	}
+
+	void markDirty(int i) noexcept { chunkDirty[i >> (2 * BoardChunkShift)] = 1; }
+	void clearDirty() noexcept { std::fill(chunkDirty.begin(), chunkDirty.end(), uint8{ 0 }); }
+	void markAllDirty() noexcept { std::fill(chunkDirty.begin(), chunkDirty.end(), uint8{ 1 }); }
+
+	// +1: Blue 支配 / -1: Red 支配 / 0: どちらでもない
+	static int OwnerOf(PaintValue p) noexcept {
+		return (p > PaintBlueOwned ? +1 : (p < PaintRedOwned ? -1 : 0));
+	}
+
+	// 塗りを書き換え、しきい値をまたいだときだけ支配数を増減
+	void setPaint(int i, PaintValue p) noexcept {
+		if (paint[i] == p) return;
+		const int before = OwnerOf(paint[i]);
+		const int after = OwnerOf(p);
+		paint[i] = p;
+		markDirty(i);
+		if (before == after) return;
+		if (before > 0) --blueTiles; else if (before < 0) --redTiles;
+		if (after > 0) ++blueTiles; else if (after < 0) ++redTiles;
+	}
+
+	// i から同じチャンク行に並ぶ n 枚（n <= BoardChunkSize）の塗りに Round(step * scale[k]) 段を足して 0..PaintMax に収める
+	// 支配数と dirty はここで直す。戻り値の crossed のタイルだけ、呼び出し側で索引を直すこと
+	PaintRunResult addPaintRun(int i, const float* scale, float step, int n) noexcept {
+		PaintValue before[BoardChunkSize];
+		const PaintRunResult r = ClampAddPaintRun(&paint[i], scale, step, n, before);
+		if (r.changed) markDirty(i);
+		for (uint32 m = r.crossed; m; m &= (m - 1)) {
+			const int k = std::countr_zero(m);
+			const int b = OwnerOf(before[k]);
+			const int a = OwnerOf(paint[i + k]);
+			if (b == a) continue;
+			if (b > 0) --blueTiles; else if (b < 0) --redTiles;
+			if (a > 0) ++blueTiles; else if (a < 0) ++redTiles;
+		}
+		return r;
+	}
+
+	void setKind(int i, TileKind k) noexcept {
+		if ((kind[i] == TileKind::Wall) != (k == TileKind::Wall)) ++wallVersion;
+		kind[i] = k;
+		markDirty(i);
+	}
+
+	// 全タイルを数え直す
+	void recountOwnership() noexcept {
+		blueTiles = redTiles = 0;
+		forEachCell([&](int, int, int i) {
+			const int o = OwnerOf(paint[i]);
+			if (o > 0) ++blueTiles; else if (o < 0) ++redTiles;
+			});
 	}
 
-	inline int idx(int x, int y) const noexcept { return (y * GW + x); }
 	bool inBounds(int x, int y) const noexcept {
-		return (0 <= x && x < GW && 0 <= y && y < GH);
+		return (0 <= x && x < w && 0 <= y && y < h);
 	}
 
 	s3d::Optional<s3d::Point> screenToCell(const s3d::Vec2& sp) const {
@@ -1,15 +1,50 @@
 ﻿#pragma once
 
 // ===================== マップ設定 =====================
+// 組み込みステージ（MapTip_Stage*）の大きさ。盤面の大きさは Board::w / h を使うこと
 inline constexpr int GW = 36;
 inline constexpr int GH = 20;
 
+// 盤面のチャンク（2^4 = 16x16 タイル）
+inline constexpr int BoardChunkShift = 4;
+inline constexpr int BoardChunkSize = (1 << BoardChunkShift);
+
+// AoE の係数表を作り置きする最大半径（これより大きい半径はその場で作る）
+inline constexpr int AoeStampCacheRadius = 16;
+
 // 画面レイアウト
 inline constexpr double UIWidth = 360.0;
 inline constexpr double Margin = 12.0;
+inline constexpr double SimTileSize = 32.0; // シミュレーション座標での1タイルの大きさ（px）
+inline constexpr int    BoardStaticLayerMaxPx = 4096; // 壁・グリッド線のキャッシュの最大辺（大きな盤面では解像度を落とす）
 
 // ターン/シミュレーション
 inline constexpr double SimDuration = 10.0;
+inline constexpr double SimTickRate = 120.0;              // 固定ステップ（Hz）
+inline constexpr double SimFixedDt = 1.0 / SimTickRate;
+inline constexpr int    SimMaxStepsPerFrame = 8;           // 1フレームで進める最大ステップ数（処理落ち時・等速あたり）
+inline constexpr int    SimFxMaxSpeed = 4;                 // これより速い倍速では演出（パーティクル・軌跡・シェイク・効果音）を出さない
+inline constexpr double SimMaxSpeedFrameBudget = 0.012;    // 最大速度のとき1フレームでシミュレーションに使う実時間（秒）
+inline constexpr uint64 ReplayKeyframeTicks = 1200;       // リプレイのシーク用に状態を取っておく間隔（ステップ数）
+inline constexpr uint64 ReplaySeekTicks = 600;            // リプレイ再生中の [←][→] で飛ぶステップ数
+
+// 実弾プールの初期容量（超えたら伸びるが、縮まない）
+inline constexpr size_t ProjectileReserveStraight = 512;
+inline constexpr size_t ProjectileReserveArc = 64;
+
+// 演出バッファの上限（満杯なら古いものから捨てる）
+inline constexpr size_t FxMaxParticles = 4096;
+inline constexpr size_t FxMaxTracers = 2048;
+inline constexpr size_t FxMaxRings = 128;
+inline constexpr size_t SimEventReserve = 4096;     // 演出イベントキューの初期容量
+
+// フレームプロファイラ（直近のフレーム数 / Chrome トレース用に持つ区間の数）
+inline constexpr size_t ProfilerFrames = 240;
+inline constexpr size_t ProfilerMaxEvents = (1 << 16);
+inline constexpr size_t ProfilerStatFrames = 60;   // 表示する平均・最大を取るフレーム数
+
+// 経路探索のキャッシュ（これを超えたら全部捨てて作り直す）
+inline constexpr size_t PathCacheMaxEntries = 256;
 
 // 経済
 inline constexpr int CostBasic = 80;
@@ -60,6 +95,15 @@ inline constexpr double EnemyExplodeHitstop = 0.04;
 // 敵スポナーの出撃間隔
 inline constexpr double EnemySpawnerInterval = 16.0; //初期値4.0f
 
+// 敵の設置プランナー（候補ごとに次ターンを何度も試しに回して一番良いものを置く）
+inline constexpr int    RedPlannerFromStage = 3;       // このステージ以降はプランナーで置く（それまではランダム）
+inline constexpr double RedPlannerBudgetSec = 0.050;   // 1ターンの思考時間（秒）。コア数が多いほど多く試せる
+inline constexpr int    RedPlannerMaxPlacements = 6;   // 1ターンに置く最大数
+inline constexpr int    RedPlannerCellsPerType = 4;    // 種類ごとに試す候補セル数
+inline constexpr int    RedPlannerMaxRollouts = 64;    // 候補ごとの試行回数の上限
+inline constexpr double RedPlannerHorizon = 4.0;       // 1試行で回す秒数（シミュレーション時間）
+inline constexpr double RedPlannerHQWeight = 0.5;      // HQ ダメージ（最大HP比）の重み。支配率差と足して評価
+
 // タレット回転設定
 inline constexpr double TurretTurnSpeed = 6.0; // rad/s（約344°/s）
 inline constexpr double SprinklerSpinSpeed = 2.8; // rad/s（スプリンクラーの常時回転速度）
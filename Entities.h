@@ -1,20 +1,71 @@
 ﻿#pragma once
 #include <Siv3D.hpp>
+#include <cmath>
 #include "Types.h"
 #include "Config.h"
 
+// ===================== 塗り（固定小数点） =====================
+// 塗りは 0..PaintMax の整数で持つ（0=Red、PaintMax=Blue）。既定は 16bit、INKWARS_PAINT_BITS=8 でビルドすると 8bit。
+// しきい値の比較も塗りの増減もこの整数のまま行う。
+#ifndef INKWARS_PAINT_BITS
+#	define INKWARS_PAINT_BITS 16
+#endif
+#if (INKWARS_PAINT_BITS == 16)
+using PaintValue = uint16;
+#elif (INKWARS_PAINT_BITS == 8)
+using PaintValue = uint8;
+#else
+#	error "INKWARS_PAINT_BITS must be 8 or 16"
+#endif
+inline constexpr int32 PaintMax = ((1 << INKWARS_PAINT_BITS) - 1);
+
+// 0..1 -> 塗り（四捨五入。範囲外は端に寄せる）
+constexpr PaintValue PaintFromUnit(double v) {
+	return (PaintValue)(v <= 0.0 ? 0 : (v >= 1.0 ? PaintMax : (int32)(v * PaintMax + 0.5)));
+}
+
+// 塗りの増減量（0..1 単位）-> 整数の段数。0 でない増減は最低1段動かす（8bit でも移動の軌跡が丸めで消えないように）
+inline int32 PaintStep(double delta) {
+	const double q = (delta * PaintMax);
+	const int32 d = (int32)std::lrint(q);
+	return ((d != 0 || q == 0.0) ? d : (q > 0.0 ? 1 : -1));
+}
+
+// d 段足して 0..PaintMax に収める
+constexpr PaintValue PaintAdd(PaintValue p, int32 d) {
+	const int32 v = ((int32)p + d);
+	return (PaintValue)(v < 0 ? 0 : (v > PaintMax ? PaintMax : v));
+}
+
+inline constexpr PaintValue PaintNeutral = PaintFromUnit(0.50);
+inline constexpr PaintValue PaintRedOwned = PaintFromUnit(0.40);	// これ未満なら Red 支配
+inline constexpr PaintValue PaintRedish = PaintFromUnit(0.45);		// これ未満なら Blue から見て敵色・Red が置ける
+inline constexpr PaintValue PaintBlueish = PaintFromUnit(0.55);	// これより上なら Red から見て敵色・Blue が置ける
+inline constexpr PaintValue PaintBlueOwned = PaintFromUnit(0.60);	// これより上なら Blue 支配
+
 // ===================== データ構造 =====================
-struct Tile {
-	TileKind kind = TileKind::Floor;
-	float paint = 0.5f; // 0..1（0=Red、1=Blue）
+// 構造物ハンドル（StructureMap のスロット番号 + 世代）。value == 0 は「なし」
+// 壊れて空いたスロットは世代を上げて使い回すので、古いハンドルは StructureMap::get で nullptr になる
+struct StructureHandle {
+	static constexpr uint32 SlotBits = 22;	// スロット数の上限 4M（1000x1000 の盤面を全部埋めても足りる）
+	static constexpr uint32 SlotMask = ((1u << SlotBits) - 1);
+	static constexpr uint32 MaxGeneration = (0xFFFFFFFFu >> SlotBits);	// 世代は 1..MaxGeneration を巡回する
+
+	uint32 value = 0;
+
+	static constexpr StructureHandle Make(uint32 slot, uint32 generation) noexcept { return StructureHandle{ ((generation << SlotBits) | slot) }; }
+	constexpr uint32 slot() const noexcept { return (value & SlotMask); }
+	constexpr uint32 generation() const noexcept { return (value >> SlotBits); }
+	constexpr explicit operator bool() const noexcept { return (value != 0); }
+	constexpr bool operator==(const StructureHandle&) const noexcept = default;
 };
 
+// 生きている構造物（壊れた・乗っ取られた構造物の抜け殻は残さない。StructureMap.h）
 struct Structure {
 	Team owner = Team::Blue;
 	StructureType type = StructureType::Basic;
 	s3d::Point cell{ 0, 0 };
 	double hp = 1.0;
-	bool alive = true;
 	double nextFire = 0.0;
 	double interval = 1.0;
 
@@ -36,42 +87,30 @@ struct Particle {
 	double size0 = 3.0, size1 = 12.0;
 };
 
-// 実弾（見える弾）
-enum class ProjKind : int32 { Bullet, Droplet, Sniper, Mortar };
-struct Projectile {
-	ProjKind kind = ProjKind::Bullet;
-	Team owner = Team::Blue;
+// 着弾リング（AoE の一瞬の輪）
+struct Ring {
 	s3d::Vec2 pos;
-	s3d::Vec2 vel;            // 直進用
-	double radius = 5.0;      // 見た目
-	// 目的
-	s3d::Point targetCell{ -1, -1 };
-	// 当たり判定/効果
-	bool blockedByWalls = true;
-	bool indirect = false;
-	int aoeRadius = 0;     // 0=単体
-	double damage = 0.0;
-	double paint = 0.0;
-	// 寿命・管理
-	double age = 0.0, life = 3.0;
-	// 放物線用
-	bool useArc = false;
-	s3d::Vec2 startPos, endPos, apexPos;
-	double u = 0.0;        // 経路の進捗0..1
-	double pathLen = 1.0;  // 経路長（px）
-	double pathSpeed = 600.0; // 経路に沿って進む速度（px/s）
+	double radius = 16.0;
+	s3d::ColorF col;
+	double age = 0.0, life = 0.10;
 };
 
+// 実弾の種類（実体は ProjectilePool.h）
+enum class ProjKind : int32 { Bullet, Droplet, Sniper, Mortar };
+
 // 歩行ユニット（プレイヤー / 敵）
 struct Actor {
 	s3d::Vec2 pos{ 0,0 };
 	s3d::Vec2 lastPos{ 0,0 };
+	s3d::Vec2 prevPos{ 0,0 }; // 前ステップの位置（描画補間用）
 	double radius = 10.0;
 	double speed = 200.0;
 	double hp = 100.0;
 	bool alive = false;
-	// クリック移動用
+	// クリック移動用（path の曲がり角を pathNext から順にたどり、最後に moveTarget へ）
 	s3d::Optional<s3d::Vec2> moveTarget;
+	s3d::Array<s3d::Vec2> path;
+	size_t pathNext = 0;
 	// 時間で消える
 	double life = 0.0; // 秒
 	double age = 0.0;  // 経過秒
@@ -0,0 +1,91 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Board.h"
+
+// ===================== 敵ユニットの誘導場 =====================
+// 生きている Blue 構造物のセルを起点に、壁以外の全セルへの歩数（4近傍 BFS）を持つ。
+// 各セルには「次に進む隣のセル」を前計算しておくので、ユニットは自分のセルを引くだけで向きが決まる。
+// 斜めに進むのは両隣が通れるときだけ（壁の角をこすらない）。
+// 作り直すのは壁か Blue 構造物の配置が変わったときだけ。
+class FlowField {
+public:
+	static constexpr int32 Unreachable = INT32_MAX;
+
+	void rebuild(const Board& brd) {
+		const size_t n = brd.tileCount();
+		m_dist.assign(n, Unreachable);
+		m_next.assign(n, NoStep);
+		m_queue.clear();
+
+		brd.forEachCell([&](int x, int y, int i) {
+			if (brd.blueIndex[i] && passable(brd, i)) {
+				m_dist[i] = 0;
+				m_queue << s3d::Point{ x, y };
+			}
+			});
+
+		for (size_t head = 0; head < m_queue.size(); ++head) {
+			const s3d::Point c = m_queue[head];
+			const int32 d = (m_dist[brd.idx(c.x, c.y)] + 1);
+			for (int k = 0; k < 4; ++k) {
+				const s3d::Point o = (c + Steps[k]);
+				if (!brd.inBounds(o.x, o.y)) continue;
+				const int j = brd.idx(o.x, o.y);
+				if (m_dist[j] != Unreachable || !passable(brd, j)) continue;
+				m_dist[j] = d;
+				m_queue << o;
+			}
+		}
+
+		// 各セルの下り方向（いちばん歩数の小さい隣。斜めは 2 歩ぶん縮むので通れれば優先される）
+		brd.forEachCell([&](int x, int y, int i) {
+			const int32 d = m_dist[i];
+			if (d == 0 || d == Unreachable) return;
+			int32 best = d;
+			for (int k = 0; k < 8; ++k) {
+				const s3d::Point o{ x + Steps[k].x, y + Steps[k].y };
+				if (!brd.inBounds(o.x, o.y)) continue;
+				const int j = brd.idx(o.x, o.y);
+				if (m_dist[j] >= best) continue;
+				if (k >= 4 && !(passable(brd, brd.idx(o.x, y)) && passable(brd, brd.idx(x, o.y)))) continue;
+				best = m_dist[j];
+				m_next[i] = (int8)k;
+			}
+			});
+
+		m_wallVersion = brd.wallVersion;
+	}
+
+	// 壁が作り直し後に変わっていれば true
+	bool isStale(const Board& brd) const noexcept {
+		return (m_dist.size() != brd.tileCount() || m_wallVersion != brd.wallVersion);
+	}
+
+	// Blue 構造物までの歩数（届かなければ Unreachable）
+	int32 distanceAt(int i) const noexcept { return m_dist[i]; }
+
+	// pos から次に向かう方向（目標セルの上ではその中心へ。届かない・盤面外は 0）
+	s3d::Vec2 direction(const Board& brd, const s3d::Vec2& pos) const {
+		const auto oc = brd.posToCell(pos);
+		if (!oc || isStale(brd)) return s3d::Vec2{ 0, 0 };
+		const int i = brd.idx(oc->x, oc->y);
+		if (m_dist[i] == 0) return (brd.cellCenter(*oc) - pos);
+		const int8 k = m_next[i];
+		if (k == NoStep) return s3d::Vec2{ 0, 0 };
+		return (brd.cellCenter(*oc + Steps[k]) - pos);
+	}
+
+private:
+	static constexpr int8 NoStep = -1;
+	// 0..3: 上下左右 / 4..7: 斜め
+	static constexpr s3d::Point Steps[8] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+	s3d::Array<int32> m_dist;	// Board::idx() 順
+	s3d::Array<int8> m_next;	// 次に進む方向（Steps の添字）
+	s3d::Array<s3d::Point> m_queue;
+	uint32 m_wallVersion = 0;
+
+	static bool passable(const Board& brd, int i) noexcept {
+		return (brd.kind[i] != TileKind::Wall);
+	}
+};
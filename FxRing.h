@@ -0,0 +1,74 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+
+// ===================== 演出用リングバッファ =====================
+// 容量固定（作成時に確保し、以降は再確保しない）。満杯で push すると一番古い要素を上書きする。
+// 寿命切れの除去は古い順を保ったままその場で詰める。
+template <class T>
+class FxRing {
+public:
+	FxRing() = default;
+	explicit FxRing(size_t capacity) : m_data(capacity) {}
+
+	// 容量を変える（中身は捨てる）
+	void setCapacity(size_t capacity) {
+		m_data = s3d::Array<T>(capacity);
+		m_head = m_count = 0;
+	}
+
+	// 新しい要素の枠を返す（満杯なら一番古い要素を捨てる）。容量 0 なら nullptr
+	T* push() {
+		const size_t cap = m_data.size();
+		if (cap == 0) { ++m_evicted; return nullptr; }
+		if (m_count == cap) {
+			m_head = ((m_head + 1) % cap);
+			--m_count;
+			++m_evicted;
+		}
+		T& slot = m_data[(m_head + m_count) % cap];
+		++m_count;
+		if (m_peak < m_count) m_peak = m_count;
+		slot = T{};
+		return &slot;
+	}
+
+	void push(const T& value) {
+		if (T* p = push()) *p = value;
+	}
+
+	// alive(T&) が false を返した要素を取り除く（古い順を保つ）
+	template <class Fn>
+	void update(Fn alive) {
+		const size_t cap = m_data.size();
+		size_t w = 0;
+		for (size_t r = 0; r < m_count; ++r) {
+			T& src = m_data[(m_head + r) % cap];
+			if (!alive(src)) continue;
+			if (w != r) m_data[(m_head + w) % cap] = src;
+			++w;
+		}
+		m_count = w;
+	}
+
+	// 古い順に走査
+	template <class Fn>
+	void each(Fn fn) const {
+		const size_t cap = m_data.size();
+		for (size_t i = 0; i < m_count; ++i) fn(m_data[(m_head + i) % cap]);
+	}
+
+	void clear() noexcept { m_head = m_count = 0; }
+
+	size_t size() const noexcept { return m_count; }
+	size_t capacity() const noexcept { return m_data.size(); }
+	size_t peak() const noexcept { return m_peak; }			// 最大同時数
+	size_t evicted() const noexcept { return m_evicted; }	// 満杯で捨てた数（累計）
+	void resetStats() noexcept { m_peak = m_count; m_evicted = 0; }
+
+private:
+	s3d::Array<T> m_data;
+	size_t m_head = 0;	// 一番古い要素
+	size_t m_count = 0;
+	size_t m_peak = 0;
+	size_t m_evicted = 0;
+};
@@ -1,266 +1,95 @@
 ﻿#include "Game.h"
-#include "map.h"
 
 using namespace s3d;
 
-// 構造物用テクスチャのローダー/アクセサ（初回呼び出し時にロード）
 namespace {
-	// CurrentDirectory から複数候補を試してロードする
-	static Texture LoadTex(const FilePath& relUnderRom) {
-		const Array<FilePath> candidates = {
-			U"Rom/" + relUnderRom,
-			U"rom/" + relUnderRom,
-			U"../Rom/" + relUnderRom,
-			U"../rom/" + relUnderRom,
-			U"../../Rom/" + relUnderRom,
-			U"../../rom/" + relUnderRom,
-		};
-		for (const auto& p : candidates) {
-			if (FileSystem::Exists(p)) {
-				Texture t{ p };
-				if (t) {
-					return t;
-				}
+	// 塗り値 -> タイル色（0=Red、中立=白、PaintMax=Blue）。色は上位 8bit で引く表にしておく
+	static Color PaintColor(PaintValue paint) {
+		static const std::array<Color, 256> table = [] {
+			std::array<Color, 256> t;
+			for (int v = 0; v < 256; ++v) {
+				const double s = (v / 255.0 - 0.5) * 2.0; // -1..1
+				if (s >= 0) t[v] = TeamColor(Team::Blue).lerp(ColorF{ 1.0 }, 1.0 - s).toColor();
+				else        t[v] = TeamColor(Team::Red).lerp(ColorF{ 1.0 }, 1.0 - (-s)).toColor();
 			}
-		}
-		return {};
-	}
-
-	// Rom系からオーディオを探してロード
-	static Audio LoadSnd(const FilePath& relUnderRom) {
-		const Array<FilePath> candidates = {
-			U"Rom/" + relUnderRom,
-			U"rom/" + relUnderRom,
-			U"../Rom/" + relUnderRom,
-			U"../rom/" + relUnderRom,
-			U"../../Rom/" + relUnderRom,
-			U"../../rom/" + relUnderRom,
-		};
-		for (const auto& p : candidates) {
-			if (FileSystem::Exists(p)) {
-				Audio a{ p };
-				if (a) return a;
-			}
-		}
-		return {};
-	}
-
-	const Texture& GetStructureTexture(StructureType t) {
-		static bool initialized = false;
-		static Texture texBasic, texSprinkler, texPump, texSniper, texMortar, texHQ, texSpawner;
-
-		if (!initialized) {
-			texBasic = LoadTex(U"texture/T_sBasic.png");
-			texSprinkler = LoadTex(U"texture/T_sSprinkler.png");
-			texPump = LoadTex(U"texture/T_sPump.png");
-			texSniper = LoadTex(U"texture/T_sSniper.png");
-			texMortar = LoadTex(U"texture/T_sMortar.png");
-			texHQ = LoadTex(U"texture/T_sHQ.png");
-			initialized = true;
-		}
-
-		switch (t) {
-		case StructureType::Basic:     return texBasic;
-		case StructureType::Sprinkler: return texSprinkler;
-		case StructureType::Pump:      return texPump;
-		case StructureType::Sniper:    return texSniper;
-		case StructureType::Mortar:    return texMortar;
-		case StructureType::HQ:        return texHQ;
-		case StructureType::spawner:   return texSpawner;
-		default:                       return texBasic;
-		}
-	}
-
-	// 角度を [-pi, pi] に正規化
-	static double WrapAngle(double a) {
-		while (a <= -Math::Pi) a += Math::TwoPi;
-		while (a > Math::Pi) a -= Math::TwoPi;
-		return a;
-	}
-
-	// 目標へ最大回転量で寄せる
-	static double StepAngleTowards(double current, double target, double maxStep) {
-		const double d = WrapAngle(target - current);
-		const double step = Clamp(d, -maxStep, maxStep);
-		return WrapAngle(current + step);
+			return t;
+			}();
+		return table[paint >> (INKWARS_PAINT_BITS - 8)];
 	}
 }
 
-// ====== Audio 初期化 ======
-void Game::initAudio() {
-	if (audioReady) return;
+// ====== テクスチャ・効果音 ======
+void Game::registerAssets() {
+	// 構造物
+	texStructures[(size_t)StructureType::Basic] = assets.texture(U"texture/T_sBasic.png");
+	texStructures[(size_t)StructureType::Sprinkler] = assets.texture(U"texture/T_sSprinkler.png");
+	texStructures[(size_t)StructureType::Pump] = assets.texture(U"texture/T_sPump.png");
+	texStructures[(size_t)StructureType::Sniper] = assets.texture(U"texture/T_sSniper.png");
+	texStructures[(size_t)StructureType::Mortar] = assets.texture(U"texture/T_sMortar.png");
+	texStructures[(size_t)StructureType::HQ] = assets.texture(U"texture/T_sHQ.png");
 
 	// 発射音
-	sfxShotBasic = LoadSnd(U"audio/T_sBasic.mp3");
-	sfxShotSprinkler = LoadSnd(U"audio/T_sSprinkler.mp3");
-	sfxShotSniper = LoadSnd(U"audio/T_sSniper.mp3");
-	sfxShotMortar = LoadSnd(U"audio/T_sMortar.mp3");
+	sfxShotBasic = assets.sound(U"audio/T_sBasic.mp3");
+	sfxShotSprinkler = assets.sound(U"audio/T_sSprinkler.mp3");
+	sfxShotSniper = assets.sound(U"audio/T_sSniper.mp3");
+	sfxShotMortar = assets.sound(U"audio/T_sMortar.mp3");
 
 	// 結果SE / UI
-	sfxStageClear = LoadSnd(U"audio/StageClear.wav");
-	sfxGameOver = LoadSnd(U"audio/gameOver.wav");
-	sfxUIButton = LoadSnd(U"audio/Buttom.mp3");
+	sfxStageClear = assets.sound(U"audio/StageClear.wav");
+	sfxGameOver = assets.sound(U"audio/gameOver.wav");
+	sfxUIButton = assets.sound(U"audio/Buttom.mp3");
+}
 
-	audioReady = true;
+void Game::playSfx(SoundHandle h, double volume) const {
+	if (const Audio& a = assets.get(h)) a.playOneShot(volume);
 }
 
 void Game::layout() {
 	const double leftW = Scene::Width() - UIWidth - 2 * Margin;
 	const double leftH = Scene::Height() - 2 * Margin;
-	const double ts1 = leftW / GW;
-	const double ts2 = leftH / GH;
-	brd.tileSize = Min(ts1, ts2);
-	const double gridW = brd.tileSize * GW;
-	const double gridH = brd.tileSize * GH;
-	brd.gridRect = RectF{ Margin, Margin, gridW, gridH };
+	const double ts1 = leftW / Max(1, sim.brd.w);
+	const double ts2 = leftH / Max(1, sim.brd.h);
+	const double ts = Min(ts1, ts2);
+	viewScale = ts / sim.brd.tileSize;
+	viewOffset = Vec2{ Margin, Margin };
+	viewRect = RectF{ Margin, Margin, ts * sim.brd.w, ts * sim.brd.h };
 }
 
-void Game::buildMapForStage(int stageNo) {
-	//for (int y = 0; y < GH; ++y) {
-	//	for (int x = 0; x < GW; ++x) {
-	//		Tile& t = brd.tiles[brd.idx(x, y)];
-	//		bool makeWall = false;
-
-	//		switch (stage)
-	//		{
-	//		case 1:
-	//			if (MapTip_Stage1[y][x] == '0') makeWall = true;
-	//			else if (MapTip_Stage1[y][x] == 'P') bHQ = { x, y }; //自軍HQ設置
-	//			else if (MapTip_Stage1[y][x] == 'E') rHQ = { x, y }; //敵軍HQ設置
-	//			else if (MapTip_Stage1[y][x] == 'r') t.paint = 0.20f;
-	//			else if (MapTip_Stage1[y][x] == 'b') t.paint = 0.80f;
-	//			else if (MapTip_Stage1[y][x] == 't') t.paint = 0.21f; //タレットを配置するための印をつけとく
-	//			else if (MapTip_Stage1[y][x] == 's') t.paint = 0.22f;
-	//			else if (MapTip_Stage1[y][x] == 'p') t.paint = 0.23f;
-	//			else  t.paint = 0.50f;
-	//			break;
-
-	//		case 2:
-	//			if (MapTip_Stage2[y][x] == '0') makeWall = true;
-	//			else if (MapTip_Stage2[y][x] == 'P') bHQ = { x, y }; //自軍HQ設置
-	//			else if (MapTip_Stage2[y][x] == 'E') rHQ = { x, y }; //敵軍HQ設置
-	//			else if (MapTip_Stage2[y][x] == 'r') t.paint = 0.20f;
-	//			else if (MapTip_Stage2[y][x] == 'b') t.paint = 0.80f;
-	//			else if (MapTip_Stage2[y][x] == 't') t.paint = 0.21f; //タレットを配置するための印をつけとく
-	//			else if (MapTip_Stage2[y][x] == 's') t.paint = 0.22f;
-	//			else if (MapTip_Stage2[y][x] == 'p') t.paint = 0.23f;
-	//			else  t.paint = 0.50f;
-	//			break;
-
-	//		case 3:
-	//			if (MapTip_Stage3[y][x] == '0') makeWall = true;
-	//			else if (MapTip_Stage3[y][x] == 'P') bHQ = { x, y }; //自軍HQ設置
-	//			else if (MapTip_Stage3[y][x] == 'E') rHQ = { x, y }; //敵軍HQ設置
-	//			else if (MapTip_Stage3[y][x] == 'r') t.paint = 0.20f;
-	//			else if (MapTip_Stage3[y][x] == 'b') t.paint = 0.80f;
-	//			else if (MapTip_Stage3[y][x] == 't') t.paint = 0.21f; //タレットを配置するための印をつけとく
-	//			else if (MapTip_Stage3[y][x] == 's') t.paint = 0.22f;
-	//			else if (MapTip_Stage3[y][x] == 'p') t.paint = 0.23f;
-	//			else  t.paint = 0.50f;
-	//			break;
-
-	//		default:
-	//			if (MapTip_Stage3[y][x] == '0') makeWall = true;
-	//			else if (MapTip_Stage3[y][x] == 'P') bHQ = { x, y }; //自軍HQ設置
-	//			else if (MapTip_Stage3[y][x] == 'E') rHQ = { x, y }; //敵軍HQ設置
-	//			else if (MapTip_Stage3[y][x] == 'r') t.paint = 0.20f;
-	//			else if (MapTip_Stage3[y][x] == 'b') t.paint = 0.80f;
-	//			else if (MapTip_Stage3[y][x] == 't') t.paint = 0.21f; //タレットを配置するための印をつけとく
-	//			else if (MapTip_Stage3[y][x] == 's') t.paint = 0.22f;
-	//			else if (MapTip_Stage3[y][x] == 'p') t.paint = 0.23f;
-	//			else  t.paint = 0.50f;
-
-	//		}
-
-	//		if (makeWall) {
-	//			t.kind = TileKind::Wall;
-	//			t.paint = 0.5f;
-	//			continue;
-	//		}
-
-	//		//if (x < GW / 2 - 2)      t.paint = 0.80f;
-	//		//else if (x > GW / 2 + 1) t.paint = 0.20f;
-	//		//else
-	//		//                   t.paint = 0.50f;
-	//		t.kind = TileKind::Floor;
-	//	}
-	//}
-	
-	// Audio を最初に準備
-	initAudio();
-
-	brd.init();
-
-	Point bHQ{ -1, -1 };
-	Point rHQ{ -1, -1 };
-
-	for (int y = 0; y < GH; ++y) {
-		for (int x = 0; x < GW; ++x) {
-			Tile& t = brd.tiles[brd.idx(x, y)];
-			bool makeWall = false;
-
-			if (MapTip_Stage1[y][x] == '0') makeWall = true;
-			if (MapTip_Stage1[y][x] == 'P') bHQ = { x, y }; //自軍HQ設置
-			if (MapTip_Stage1[y][x] == 'E') rHQ = { x, y }; //敵軍HQ設置
-
-			if (makeWall) {
-				t.kind = TileKind::Wall;
-				t.paint = 0.5f;
-				continue;
-			}
-			if (x < GW / 2 - 2)      t.paint = 0.80f;
-			else if (x > GW / 2 + 1) t.paint = 0.20f;
-			else                     t.paint = 0.50f;
-			t.kind = TileKind::Floor;
-		}
-	}
+// シミュレーション座標 -> 画面座標
+Mat3x2 Game::boardTransform(const Vec2& shake) const {
+	return Mat3x2::Scale(viewScale).translated(viewOffset + shake);
+}
 
-	// HQ 設置処理
-	brd.tiles[brd.idx(bHQ.x, bHQ.y)].kind = TileKind::HQBlue;
-	brd.tiles[brd.idx(rHQ.x, rHQ.y)].kind = TileKind::HQRed;
-	brd.tiles[brd.idx(bHQ.x, bHQ.y)].paint = 1.0f;
-	brd.tiles[brd.idx(rHQ.x, rHQ.y)].paint = 0.0f;
+Optional<Point> Game::cursorCell() const {
+	const Vec2 p = (Cursor::PosF() - viewOffset) / viewScale;
+	return sim.brd.posToCell(p);
+}
 
-	blues.clear(); reds.clear();
-	tracers.clear(); particles.clear(); projectiles.clear();
-	redAgents.clear();
-	player.reset();
-	stageCleared = false;
-	turnCount = 1;
-	phase = Phase::Planning;
+void Game::startMatch(uint64 seed) {
+	matchSeed = seed;
+	sim.seed = seed;
+	simTick = 0;
+	recorder.begin(seed, 1);
+	buildMapForStage(1);
+}
 
-	Structure sb; sb.owner = Team::Blue; sb.type = StructureType::HQ; sb.cell = bHQ; sb.hp = GetSpec(StructureType::HQ).maxHP; sb.alive = true;
-	Structure sr; sr.owner = Team::Red;  sr.type = StructureType::HQ; sr.cell = rHQ; sr.hp = GetSpec(StructureType::HQ).maxHP; sr.alive = true;
-	blues << sb; reds << sr;
-	brd.blueIndex[brd.idx(bHQ.x, bHQ.y)] = 0;
-	brd.redIndex[brd.idx(rHQ.x, rHQ.y)] = 0;
-	blueHQ = 0; redHQ = 0;
-
-	auto placeRed = [&](StructureType t, Point c) {
-		if (!brd.inBounds(c.x, c.y)) return;
-		if (brd.tiles[brd.idx(c.x, c.y)].kind != TileKind::Floor) return;
-		if (brd.redIndex[brd.idx(c.x, c.y)] != -1) return;
-		if (brd.blueIndex[brd.idx(c.x, c.y)] != -1) return;
-		Structure s; s.owner = Team::Red; s.type = t; s.cell = c; s.hp = GetSpec(t).maxHP; s.alive = true;
-		reds << s;
-		brd.redIndex[brd.idx(c.x, c.y)] = (int)reds.size() - 1;
-		brd.tiles[brd.idx(c.x, c.y)].paint = 0.2f;
-		};
-	placeRed(StructureType::Basic, Point{ GW - 7, GH / 2 - 3 });
-	placeRed(StructureType::Sprinkler, Point{ GW - 8, GH / 2 + 2 });
-	placeRed(StructureType::Mortar, Point{ GW - 10, GH / 2 });
+void Game::buildMapForStage(int stageNo) {
+	// タイトル画面の間に読み終わっていなかったものはここで待つ
+	assets.finishAll();
 
-	if (stageNo >= 2) {
-		placeRed(StructureType::Basic, Point{ GW - 12, GH / 2 - 6 });
-		placeRed(StructureType::Sniper, Point{ GW - 8,  GH / 2 - 1 });
-	}
-	if (stageNo >= 3) {
-		placeRed(StructureType::Mortar, Point{ GW - 14, GH / 2 + 5 });
-		placeRed(StructureType::Sprinkler, Point{ GW - 6,  GH / 2 + 6 });
-	}
+	sim.buildMapForStage(stageNo);
+	resetViewForStage();
+}
 
-	moneyBlue = 120 + 20 * (stageNo - 1);
-	moneyRed = 140 + 40 * (stageNo - 1);
+// 盤面を作り直した後の表示側の初期化（sim はそのまま）
+void Game::resetViewForStage() {
+	staticDirty = true;
+	simAccum = 0.0;
+	renderAlpha = 1.0;
+
+	tracers.clear(); particles.clear(); rings.clear();
+	stageCleared = false;
+	phase = Phase::Planning;
 
 	stageStarting = true;
 	stageBannerT = 0.0;
@@ -300,1066 +129,705 @@ void Game::SpawnParticles(const Vec2& p, const ColorF& col, int n, double vmin,
 	for (int i = 0; i < n; ++i) {
 		const double a = Random(0.0, Math::TwoPi);
 		const double sp = Random(vmin, vmax);
-		Particle fx;
+		Particle* slot = particles.push();
+		if (!slot) return;
+		Particle& fx = *slot;
 		fx.pos = p;
 		fx.vel = Vec2{ Cos(a), Sin(a) } * sp;
 		fx.col = col;
 		fx.age = 0.0; fx.life = Random(lifeMin, lifeMax);
 		fx.size0 = Random(s0 * 0.8, s0 * 1.2);
 		fx.size1 = Random(s1 * 0.8, s1 * 1.2);
-		particles << fx;
 	}
 }
 
-// 勝敗条件
-bool Game::isBlueWin() const {
-	auto [bp, rp] = Ownership(brd);
-	const bool redHQDead = (redHQ >= 0 && !reds[redHQ].alive);
-	return (bp >= 0.98) || redHQDead;
-}
-bool Game::isBlueLose() const {
-	auto [bp, rp] = Ownership(brd);
-	const bool blueHQDead = (blueHQ >= 0 && !blues[blueHQ].alive);
-	return (rp >= 0.98) || blueHQDead;
-}
-
-// 敵AIの簡易設置
-void Game::enemyPlaceAI() {
-	int tries = 18;
-	const int minCost = Min({ CostBasic, CostSprinkler, CostMortar, CostSpawner });
-	while (tries-- > 0) {
-		if (moneyRed < minCost) break;
-
-		Array<StructureType> bag;
-		if (moneyRed >= CostBasic)     bag << StructureType::Basic;
-		if (moneyRed >= CostSprinkler) bag << StructureType::Sprinkler;
-		if (moneyRed >= CostMortar)    bag << StructureType::Mortar;
-		if (stage >= 2 && moneyRed >= CostSniper && RandomBool(0.35)) bag << StructureType::Sniper;
-		if (moneyRed >= CostPump && RandomBool(0.25)) bag << StructureType::Pump;
-		if (moneyRed >= CostSpawner && RandomBool(0.20)) bag << StructureType::spawner;
-
-		if (bag.isEmpty()) break;
-
-		const StructureType pick = bag.choice();
-		for (int k = 0; k < 100; ++k) {
-			const int x = Random(GW / 2 + 1, GW - 2);
-			const int y = Random(1, GH - 2);
-			if (brd.tiles[brd.idx(x, y)].kind != TileKind::Floor) continue;
-			if (brd.redIndex[brd.idx(x, y)] != -1) continue;
-			if (brd.blueIndex[brd.idx(x, y)] != -1) continue;
-
-			const float p = brd.tiles[brd.idx(x, y)].paint;
-			if (p > 0.45f) continue;
-
-			Structure s; s.owner = Team::Red; s.type = pick; s.cell = { x, y };
-			s.hp = GetSpec(pick).maxHP; s.alive = true;
-			reds << s;
-			brd.redIndex[brd.idx(x, y)] = (int)reds.size() - 1;
-			moneyRed -= GetSpec(pick).cost;
-
-			if (pick == StructureType::spawner) {
-				spawnEnemyAt({ x, y });
+// シミュレーションを進める（固定ステップ時は貯めて SimFixedDt 刻みで消化）
+bool Game::advanceSim(double dt) {
+	// 倍速は自動戦闘中だけ。速すぎるときは演出イベントを積まない（結果は変わらない）
+	const int speed = (phase == Phase::Simulating ? effectiveSimSpeed() : 1);
+	sim.eventsEnabled = (speed != 0 && speed <= SimFxMaxSpeed);
+
+	if (!fixedTimestep) {
+		renderAlpha = 1.0;
+		if (phase != Phase::Simulating) { ++simTick; sim.updatePlayer(dt); return false; }
+		for (int i = 0; i < Max(speed, 1); ++i) {
+			++simTick;
+			if (sim.step(dt)) return true;
+		}
+		return false;
+	}
+
+	// 最大速度：フレームの予算いっぱいまで回す
+	if (speed == 0) {
+		simAccum = 0.0;
+		renderAlpha = 1.0;
+		const Stopwatch sw{ StartImmediately::Yes };
+		do {
+			++simTick;
+			if (sim.step(SimFixedDt)) return true;
+		} while (sw.sF() < SimMaxSpeedFrameBudget);
+		return false;
+	}
+
+	simAccum += dt * speed;
+	int steps = 0;
+	while (simAccum >= SimFixedDt) {
+		simAccum -= SimFixedDt;
+		++simTick;
+		if (phase == Phase::Simulating) {
+			if (sim.step(SimFixedDt)) {
+				simAccum = 0.0;
+				renderAlpha = 1.0;
+				return true;
 			}
-			break;
 		}
-	}
-}
-
-// ===================== シミュレーション処理 =====================
-void Game::beginSimulation() {
-	phase = Phase::Simulating;
-	simTime = SimDuration;
-	simElapsed = 0.0;
-	tracers.clear();
-	projectiles.clear();
-
-	auto setup = [&](Array<Structure>& a) {
-		for (auto& s : a) {
-			if (!s.alive) continue;
-			const TypeSpec& spec = GetSpec(s.type);
-			if (spec.shots > 0) {
-				s.interval = (SimDuration / spec.shots);
-				s.nextFire = 0.0;
-			}
-			else {
-				s.interval = 9999.0;
-				s.nextFire = 9999.0;
-			}
+		else {
+			sim.updatePlayer(SimFixedDt);
 		}
-		};
-	setup(blues);
-	setup(reds);
-
-	for (auto& s : reds) {
-		if (s.alive && s.type == StructureType::spawner) {
-			s.interval = EnemySpawnerInterval;
-			s.nextFire = 0.0;
+		// 処理落ち時は遅れを捨てる（シミュレーション結果は変わらず、進みが遅くなるだけ）
+		if (++steps >= SimMaxStepsPerFrame * speed) {
+			simAccum = 0.0;
+			break;
 		}
 	}
-
-	stageStarting = false;
-}
-
-void Game::endSimulationAndScore() {
-	auto [bp, rp] = Ownership(brd);
-	const int blueTiles = (int)(bp * GW * GH);
-	const int redTiles = (int)(rp * GW * GH);
-	moneyBlue += blueTiles * IncomePerTile;
-	moneyRed += redTiles * IncomePerTile;
-
-	int bluePump = 0, redPump = 0;
-	for (const auto& s : blues) if (s.alive && s.type == StructureType::Pump) ++bluePump;
-	for (const auto& s : reds)  if (s.alive && s.type == StructureType::Pump)  ++redPump;
-	moneyBlue += bluePump * IncomePerPump;
-	moneyRed += redPump * IncomePerPump;
-
-	enemyPlaceAI();
-
-	phase = Phase::Planning;
-	turnCount += 1;
+	renderAlpha = (simAccum / SimFixedDt);
+	return false;
 }
 
-void Game::gotoNextStage() {
-	for (int i = 0; i < 10; ++i) {
-		SpawnParticles(brd.gridRect.center() + RandomVec2(Circle{ brd.gridRect.h * 0.2 }),
-					   HSV{ 120 + Random(-20, 20), 0.8, 1.0 }, 30, 120, 260, 0.4, 0.9, 3, 18);
+// ===================== 自動戦闘の速度 =====================
+void Game::cycleSimSpeed() {
+	switch (simSpeed) {
+	case 1:  simSpeed = 2; break;
+	case 2:  simSpeed = 4; break;
+	case 4:  simSpeed = 16; break;
+	case 16: simSpeed = 0; break;
+	default: simSpeed = 1; break;
 	}
-	moneyBlue = Min(moneyBlue + 60, 9999);
-	moneyRed = 140 + 40 * (stage);
-	stage += 1;
-	buildMapForStage(stage);
-	clearShakeAndHitStop();
 }
 
-// タイル塗り
-void Game::applyPaintAt(const Point& c, double delta) {
-	if (!brd.inBounds(c.x, c.y)) return;
-	Tile& t = brd.tiles[brd.idx(c.x, c.y)];
-	const double nv = (double)t.paint + delta;
-	t.paint = (float)(nv < 0.0 ? 0.0 : (nv > 1.0 ? 1.0 : nv));
-}
-
-// 構造体ダメージ（乗っ取り対応）
-void Game::damageAt(const Point& c, double dmg, Team attacker) {
-	if (!brd.inBounds(c.x, c.y)) return;
-
-	if (attacker == Team::Blue) {
-		int idxR = brd.redIndex[brd.idx(c.x, c.y)];
-		if (idxR >= 0) {
-			Structure& s = reds[idxR];
-			if (!s.alive) return;
-			s.hp -= dmg;
-			if (s.hp <= 0.0) {
-				// 乗っ取り（HQ は除く）
-				const bool wasHQ = (s.type == StructureType::HQ);
-				if (!wasHQ) {
-					captureStructureAt(c, Team::Red, Team::Blue);
-				}
-				else {
-					// HQ は破壊扱い
-					s.alive = false;
-					brd.redIndex[brd.idx(c.x, c.y)] = -1;
-				}
-
-				// 視覚効果・ペイント（Blue 側）
-				applyPaintAt(c, +0.20);
-				SpawnParticles(brd.cellCenter(c), HSV{ 210,0.7,1.0 }, 28, 150, 320, 0.30, 0.6, 3, 20);
-				AddShake(8.0, 0.15);
-				hitStopTimer = Max(hitStopTimer, 0.04);
-			}
-		}
-	}
-	else if (attacker == Team::Red) {
-		int idxB = brd.blueIndex[brd.idx(c.x, c.y)];
-		if (idxB >= 0) {
-			Structure& s = blues[idxB];
-			if (!s.alive) return;
-			s.hp -= dmg;
-			if (s.hp <= 0.0) {
-				const bool wasHQ = (s.type == StructureType::HQ);
-				if (!wasHQ) {
-					captureStructureAt(c, Team::Blue, Team::Red);
-				}
-				else {
-					// HQ は破壊扱い
-					s.alive = false;
-					brd.blueIndex[brd.idx(c.x, c.y)] = -1;
-				}
-
-				// 視覚効果・ペイント（Red 側）
-				applyPaintAt(c, -0.20);
-				SpawnParticles(brd.cellCenter(c), HSV{ 0,0.7,1.0 }, 28, 150, 320, 0.30, 0.6, 3, 20);
-				AddShake(8.0, 0.15);
-				hitStopTimer = Max(hitStopTimer, 0.04);
-			}
-		}
-	}
+// スキップ：このターンの残りを最大速度で最後までシミュレーションする（打ち切りはしない）
+void Game::skipTurn() {
+	if (phase != Phase::Simulating) return;
+	skipping = true;
+	clearShakeAndHitStop();
 }
 
-// AoE
-void Game::applyAOE(const Point& center, int r, double paintDelta, double dmg, Team atk) {
-	const int r2 = r * r;
-	for (int dy = -r; dy <= r; ++dy) for (int dx = -r; dx <= r; ++dx) {
-		const int d2 = dx * dx + dy * dy;
-		if (d2 > r2) continue;
-		Point c{ center.x + dx, center.y + dy };
-		if (!brd.inBounds(c.x, c.y)) continue;
-		const double w = 1.0 - Sqrt((double)d2) / (double)(r + 0.001);
-		applyPaintAt(c, paintDelta * (0.5 + 0.5 * w));
-		if (dmg > 0.0) damageAt(c, dmg * (0.6 + 0.4 * w), atk);
-	}
+int Game::effectiveSimSpeed() const {
+	return (skipping ? 0 : simSpeed);
+}
+
+String Game::simSpeedLabel() const {
+	return (simSpeed == 0 ? U"最大" : U"x{}"_fmt(simSpeed));
+}
+
+// ===================== プロファイラ =====================
+void Game::updateProfilerCounters() const {
+	Profiler& prof = Profiler::Get();
+	prof.setCounter(ProfCounter::Structures, (int64)sim.structures.size());
+	prof.setCounter(ProfCounter::Projectiles, (int64)sim.projectiles.size());
+	prof.setCounter(ProfCounter::RedAgents, (int64)sim.redAgents.size());
+	prof.setCounter(ProfCounter::Particles, (int64)particles.size());
+	prof.setCounter(ProfCounter::Tracers, (int64)tracers.size());
+}
+
+// 直近 ProfilerStatFrames フレームの区間ごとの平均・最大と、フレーム時間のグラフ
+void Game::drawProfiler() const {
+	if (!showProfiler) return;
+	const Profiler& prof = Profiler::Get();
+	if (prof.frameCount() == 0) return;
+
+	constexpr size_t Zones = (size_t)ProfZone::Count;
+	std::array<double, Zones> avg{}, peak{}, calls{};
+	double frameAvg = 0.0, framePeak = 0.0, allocAvg = 0.0;
+	size_t n = 0;
+	ProfFrame last;
+	prof.eachFrame(ProfilerStatFrames, [&](const ProfFrame& f) {
+		for (size_t z = 0; z < Zones; ++z) {
+			avg[z] += f.zoneMs[z];
+			peak[z] = Max(peak[z], f.zoneMs[z]);
+			calls[z] += f.calls[z];
+		}
+		frameAvg += f.frameMs;
+		framePeak = Max(framePeak, f.frameMs);
+		allocAvg += (double)f.allocations;
+		last = f;
+		++n;
+		});
+	for (size_t z = 0; z < Zones; ++z) { avg[z] /= n; calls[z] /= n; }
+	frameAvg /= n;
+	allocAvg /= n;
+
+	const double lineH = 17.0;
+	const RectF panel{ viewRect.x + 8, viewRect.y + 8, 400, lineH * (Zones + 7) + 80 };
+	panel.draw(ColorF{ 0, 0, 0, 0.72 });
+	const auto& font = FontAsset(U"UI");
+	Vec2 pos = panel.pos.movedBy(10, 6);
+
+	font(U"frame {:.2f} ms (max {:.2f}) / {:.0f} fps"_fmt(frameAvg, framePeak, 1000.0 / Max(frameAvg, 0.001))).draw(15, pos, ColorF{ 1 });
+	pos.y += lineH + 2;
+	font(U"zone").draw(13, pos, ColorF{ 0.7 });
+	font(U"avg ms").draw(13, pos.movedBy(200, 0), ColorF{ 0.7 });
+	font(U"max ms").draw(13, pos.movedBy(265, 0), ColorF{ 0.7 });
+	font(U"calls").draw(13, pos.movedBy(335, 0), ColorF{ 0.7 });
+	pos.y += lineH;
+
+	double topLevel = 0.0;
+	for (size_t z = 0; z < Zones; ++z) {
+		const ProfZoneInfo& info = ProfZoneInfos[z];
+		if (info.depth == 0) topLevel += avg[z];
+		const ColorF col = (avg[z] >= 4.0 ? ColorF{ 1, 0.5, 0.4 } : (avg[z] >= 1.0 ? ColorF{ 1, 0.9, 0.5 } : ColorF{ 0.92 }));
+		font(String{ info.name }).draw(13, pos.movedBy(info.depth * 12, 0), col);
+		font(U"{:.3f}"_fmt(avg[z])).draw(13, pos.movedBy(200, 0), col);
+		font(U"{:.3f}"_fmt(peak[z])).draw(13, pos.movedBy(265, 0), col);
+		font(U"{:.0f}"_fmt(calls[z])).draw(13, pos.movedBy(335, 0), col);
+		pos.y += lineH;
+	}
+	// 区間の外（System::Update での描画の実行・垂直同期待ちを含む）
+	font(U"(other)").draw(13, pos, ColorF{ 0.7 });
+	font(U"{:.3f}"_fmt(Max(0.0, frameAvg - topLevel))).draw(13, pos.movedBy(200, 0), ColorF{ 0.7 });
+	pos.y += lineH + 4;
+
+	String counts;
+	for (size_t c = 0; c < (size_t)ProfCounter::Count; ++c) counts += U"{} {}  "_fmt(ProfCounterNames[c], last.counters[c]);
+	font(counts).draw(13, pos, ColorF{ 0.92 });
+	pos.y += lineH;
+	font(U"allocations {:.1f} / frame   [F3] 閉じる  [F4] トレース保存"_fmt(allocAvg)).draw(13, pos, ColorF{ 0.92 });
+	pos.y += lineH;
+	font(U"assets " + assets.summary()).draw(13, pos, (assets.isReady() ? ColorF{ 0.92 } : ColorF{ 1, 0.9, 0.5 }));
+	pos.y += lineH + 6;
+
+	// フレーム時間（1本 = 1フレーム、線は 60fps / 30fps）
+	const RectF graph{ pos.x, pos.y, panel.w - 20, 50 };
+	graph.draw(ColorF{ 1, 0.06 });
+	const double msToPx = (graph.h / 40.0);
+	const double barW = (graph.w / ProfilerFrames);
+	size_t k = 0;
+	prof.frames().each([&](const ProfFrame& f) {
+		const double h = Min(graph.h, f.frameMs * msToPx);
+		const ColorF col = (f.frameMs > 33.4 ? ColorF{ 1, 0.4, 0.3 } : (f.frameMs > 16.8 ? ColorF{ 1, 0.85, 0.4 } : ColorF{ 0.4, 0.9, 0.5 }));
+		RectF{ graph.x + k * barW, graph.bottomY() - h, Max(1.0, barW - 0.5), h }.draw(col);
+		++k;
+		});
+	for (const double ms : { 1000.0 / 60.0, 1000.0 / 30.0 }) {
+		const double y = graph.bottomY() - ms * msToPx;
+		Line{ graph.x, y, graph.rightX(), y }.draw(1, ColorF{ 1, 0.35 });
+	}
+}
+
+bool Game::saveProfilerTrace() const {
+	FileSystem::CreateDirectories(U"profiles/");
+	return SaveChromeTrace(U"profiles/trace.json");
+}
+
+// ===================== セーブ・ロード / リプレイ =====================
+namespace {
+	const FilePath SaveDir = U"saves/";
+	const FilePath QuickSavePath = (SaveDir + U"quick.iwsave");
+	const FilePath ReplayDir = U"replays/";
+	const FilePath ReplayPath = (ReplayDir + U"last.iwreplay");
 }
 
-// 乗っ取り本体
-void Game::captureStructureAt(const Point& c, Team from, Team to) {
-	if (!brd.inBounds(c.x, c.y)) return;
-
-	// from -> to への乗っ取り。HQ は対象外（破壊扱い）
-	auto captureOne = [&](Array<Structure>& src, Array<Structure>& dst, int& cellIndexSrc, int& cellIndexDst) {
-		const int idx = cellIndexSrc;
-		if (idx < 0) return;
-		Structure& oldS = src[idx];
-		if (!oldS.alive) return;
-		if (oldS.type == StructureType::HQ) {
-			// HQ は乗っ取り不可：破壊
-			oldS.alive = false;
-			cellIndexSrc = -1;
-			return;
-		}
-
-		// 新オーナーの構造物を作成して追加
-		Structure ns = oldS;
-		ns.owner = to;
-		ns.hp = GetSpec(ns.type).maxHP;
-		ns.alive = true;
-
-		// 発射スケジュールを再設定（直近ですぐ撃てるように）
-		const TypeSpec& spec = GetSpec(ns.type);
-		if (spec.shots > 0) {
-			ns.interval = (SimDuration / spec.shots);
-			ns.nextFire = simElapsed; // すぐに発射可能
-		}
-		else {
-			ns.interval = 9999.0;
-			ns.nextFire = 9999.0;
-		}
-
-		dst << ns;
-		cellIndexDst = static_cast<int>(dst.size()) - 1;
-
-		// 旧側を無効化
-		oldS.alive = false;
-		cellIndexSrc = -1;
-		};
-
-	const int ci = brd.idx(c.x, c.y);
-
-	if (from == Team::Red && to == Team::Blue) {
-		captureOne(reds, blues, brd.redIndex[ci], brd.blueIndex[ci]);
-	}
-	else if (from == Team::Blue && to == Team::Red) {
-		captureOne(blues, reds, brd.blueIndex[ci], brd.redIndex[ci]);
-	}
+bool Game::quickSave() const {
+	FileSystem::CreateDirectories(SaveDir);
+	return SaveSnapshotFile(QuickSavePath, sim, phase);
 }
 
-// タレットの狙い更新・回転補間（毎フレーム）
-void Game::updateTurretAim(double dt) {
-	auto stepA = [&](Array<Structure>& a, Team /*side*/) {
-		for (auto& s : a) {
-			if (!s.alive) continue;
+// 読み込んだ時点から新しくリプレイを記録し始める
+bool Game::quickLoad() {
+	if (!LoadSnapshotFile(QuickSavePath, sim, &phase)) return false;
 
-			// スプリンクラーは常時右回転（時計回り）
-			if (s.type == StructureType::Sprinkler) {
-				s.rot = WrapAngle(s.rot + SprinklerSpinSpeed * dt);
-				continue;
-			}
+	matchSeed = sim.seed;
+	simTick = 0;
+	recorder.begin(sim.seed, sim.stage, WriteSnapshot(sim, phase));
 
-			// 他は「現在の目標角度」へスムーズに寄せる（目標角度は発射時にセット）
-			const double maxStep = TurretTurnSpeed * dt;
-			s.rot = StepAngleTowards(s.rot, s.rotTarget, maxStep);
-		}
-		};
-	stepA(blues, Team::Blue);
-	stepA(reds, Team::Red);
+	sim.eventsEnabled = true;
+	staticDirty = true;
+	simAccum = 0.0;
+	renderAlpha = 1.0;
+	skipping = false;
+	stageStarting = false;
+	stageCleared = (phase == Phase::Summary && sim.isBlueWin() && !sim.isBlueLose());
+	tracers.clear(); particles.clear(); rings.clear();
+	clearShakeAndHitStop();
+	return true;
 }
 
-// ターゲット選択
-Optional<Point> Game::findTargetCell(Team atk, const Point& from, int range, bool turretOnly) const {
-	Array<Point> cands;
-	for (int y = Max(0, from.y - range); y <= Min(GH - 1, from.y + range); ++y) {
-		for (int x = Max(0, from.x - range); x <= Min(GW - 1, from.x + range); ++x) {
-			const Point p{ x, y };
-			if (TileDist(from, p) > (double)range + 0.001) continue;
-			const Tile& t = brd.tiles[brd.idx(x, y)];
-			if (turretOnly) {
-				if (atk == Team::Blue) {
-					if (brd.redIndex[brd.idx(x, y)] >= 0) cands << p;
-				}
-				else {
-					if (brd.blueIndex[brd.idx(x, y)] >= 0) cands << p;
-				}
-			}
-			else {
-				const bool enemyish = (atk == Team::Blue ? (t.paint < 0.45f) : (t.paint > 0.55f));
-				if (enemyish) cands << p;
-			}
-		}
-	}
-	if (!cands.isEmpty()) return cands.choice();
-
-	Array<Point> any;
-	for (int y = Max(0, from.y - range); y <= Min(GH - 1, from.y + range); ++y) {
-		for (int x = Max(0, from.x - range); x <= Min(GW - 1, from.x + range); ++x) {
-			const Point p{ x, y };
-			if (TileDist(from, p) > (double)range + 0.001) continue;
-			if (brd.tiles[brd.idx(x, y)].kind == TileKind::Wall) continue;
-			any << p;
-		}
-	}
-	if (!any.isEmpty()) return any.choice();
-	return s3d::none;
+// ここまでの試合を保存
+bool Game::saveReplay() const {
+	FileSystem::CreateDirectories(ReplayDir);
+	return SaveReplayFile(ReplayPath, recorder.finish(simTick));
 }
 
-// 弾を登録
-void Game::spawnProjectile(Team atk, const TypeSpec& spec, const Vec2& muzzle, const Point& targetCell, ProjKind k, bool useArc, bool blocked, bool indirect, int aoe, double dmg, double paint, double speed, double radiusPx) {
-	Projectile pr;
-	pr.kind = k;
-	pr.owner = atk;
-	pr.blockedByWalls = blocked;
-	pr.indirect = indirect;
-	pr.aoeRadius = aoe;
-	pr.damage = dmg;
-	pr.paint = paint;
-	pr.radius = radiusPx;
-	pr.targetCell = targetCell;
-	pr.pos = muzzle;
-	pr.life = 3.0;
-
-	const Vec2 hitPos = brd.cellCenter(targetCell);
-
-	if (useArc) {
-		pr.useArc = true;
-		pr.startPos = muzzle;
-		pr.endPos = hitPos;
-		const Vec2 mid = (muzzle + hitPos) * 0.5;
-		const double dist = (hitPos - muzzle).length();
-		const double h = 60.0 + 0.25 * dist; // 距離に応じて高く
-		pr.apexPos = mid + Vec2{ 0, -h };
-		pr.u = 0.0;
-		pr.pathLen = dist;
-		pr.pathSpeed = speed;
-	}
-	else {
-		pr.useArc = false;
-		Vec2 dir = (hitPos - muzzle);
-		const double len = dir.length();
-		if (len > 0.0) dir *= (speed / len);
-		else dir = Vec2{ 0,0 };
-		pr.vel = dir;
-	}
+// 保存したリプレイを再生する（今の試合は取っておいて stopReplay で戻す）
+bool Game::startReplay() {
+	auto data = LoadReplayFile(ReplayPath);
+	if (!data) return false;
 
-	projectiles << pr;
+	replaySavedSim = sim;
+	replaySavedPhase = phase;
+	replay.emplace(std::move(*data));
+	replay->restart(sim);
 
-	// 演出
-	SpawnParticles(muzzle, TeamColor(atk), 6, 120, 260, 0.08, 0.22, 3, 10);
-	tracers << Tracer{ muzzle, muzzle + (hitPos - muzzle).setLength(18.0), TeamColor(atk).withAlpha(0.9), 0.0, 0.12 };
+	phase = Phase::Planning;
+	stageStarting = false;
+	staticDirty = true;
+	simAccum = 0.0;
+	renderAlpha = 1.0;
+	tracers.clear(); particles.clear(); rings.clear();
+	clearShakeAndHitStop();
+	return true;
 }
 
-// 1発発射
-void Game::fireOnce(Structure& s, Team atk) {
-	const TypeSpec& spec = GetSpec(s.type);
-	if (spec.shots <= 0) return;
-
-	const Vec2 muzzle = brd.cellCenter(s.cell);
-
-	// スプリンクラーは散布のみ＆回転は常時スピンに委ねる
-	if (s.type == StructureType::Sprinkler) {
-		if (sfxShotSprinkler) sfxShotSprinkler.playOneShot(0.6);
-		for (int i = 0; i < 3; ++i) {
-			Point tc = s.cell + Point{ Random(-(int)spec.range, (int)spec.range), Random(-(int)spec.range, (int)spec.range) };
-			tc.x = limit(tc.x, 0, GW - 1);
-			tc.y = limit(tc.y, 0, GH - 1);
-			spawnProjectile(atk, spec, muzzle, tc,
-				ProjKind::Droplet, false, false, false, 0, spec.damage * 0.15, spec.paint * 0.9, spec.projSpeed, spec.projRadius * 0.9);
-		}
-		return;
-	}
-
-	Optional<Point> opt = findTargetCell(atk, s.cell, spec.range, spec.targetTurretOnly);
-	if (!opt) return;
-	Point target = *opt;
-
-	// ブレ
-	if (spec.spread > 0.05) {
-		target.x += Random(-(int)spec.spread, (int)spec.spread);
-		target.y += Random(-(int)spec.spread, (int)spec.spread);
-		target.x = limit(target.x, 0, GW - 1);
-		target.y = limit(target.y, 0, GH - 1);
-	}
-
-	// 実際に撃つ方向（ブレ適用後）を目標角度に設定
-	{
-		const Vec2 hitPos = brd.cellCenter(target);
-		const double ang = Math::Atan2((hitPos - muzzle).y, (hitPos - muzzle).x);
-		s.rotTarget = ang;
-	}
-
-	// 発射音
-	if (s.type == StructureType::Mortar) {
-		if (sfxShotMortar) sfxShotMortar.playOneShot(0.9);
-		spawnProjectile(atk, spec, muzzle, target,
-			ProjKind::Mortar, true, false, true, spec.aoeRadius, spec.damage, spec.paint, spec.projSpeed, spec.projRadius);
-	}
-	else if (s.type == StructureType::Sniper) {
-		if (sfxShotSniper) sfxShotSniper.playOneShot(0.8);
-		spawnProjectile(atk, spec, muzzle, target,
-			ProjKind::Sniper, false, true, false, 0, spec.damage, spec.paint, spec.projSpeed, spec.projRadius);
-	}
-	else { // Basic
-		if (sfxShotBasic) sfxShotBasic.playOneShot(0.7);
-		spawnProjectile(atk, spec, muzzle, target,
-			ProjKind::Bullet, false, true, false, 0, spec.damage, spec.paint, spec.projSpeed, spec.projRadius);
-	}
+void Game::stopReplay() {
+	if (!replay) return;
+	replay.reset();
+	sim = replaySavedSim;
+	replaySavedSim = SimCore{};
+	phase = replaySavedPhase;
+	sim.eventsEnabled = true;
+	sim.events.clear();
+	sim.brd.markAllDirty();
+
+	staticDirty = true;
+	simAccum = 0.0;
+	renderAlpha = 1.0;
+	tracers.clear(); particles.clear(); rings.clear();
+	clearShakeAndHitStop();
 }
 
-// 弾の進行・衝突処理
-void Game::updateProjectiles(double dtReal) {
-	const double dt = dtReal;
-
-	Array<Projectile> alive;
-
-	for (auto& pr : projectiles) {
-		pr.age += dt;
-		if (pr.age > pr.life) {
-			continue; // 消滅
-		}
+// 再生：[F] 速度 / [←][→] シーク（演出は自動戦闘と同じく速すぎると出さない）
+void Game::updateReplay(double dtReal) {
+	if (!replay) return;
+	if (KeyF.down()) cycleSimSpeed();
 
-		Vec2 prev = pr.pos;
-
-		// 放物線 or 直進
-		if (pr.useArc) {
-			const double du = (pr.pathSpeed / Max(1.0, pr.pathLen)) * dt;
-			pr.u += du;
-			double u = pr.u; if (u > 1.0) u = 1.0;
-			const double v = (1.0 - u);
-			pr.pos = (v * v) * pr.startPos + (2.0 * v * u) * pr.apexPos + (u * u) * pr.endPos;
-
-			tracers << Tracer{ prev, pr.pos, TeamColor(pr.owner), 0.0, 0.10 };
-
-			if (pr.u >= 1.0) {
-				const Point ic = brd.screenToCell(pr.endPos).value_or(pr.targetCell);
-				impactAt(pr, ic);
-				continue;
-			}
-			alive << pr;
-		}
-		else {
-			Vec2 remain = pr.vel * dt;
-			int subSteps = Max(1, (int)Ceil(remain.length() / (brd.tileSize * 0.5)));
-			Vec2 step = remain / (double)subSteps;
-			bool hit = false;
-			for (int i = 0; i < subSteps; ++i) {
-				prev = pr.pos;
-				pr.pos += step;
-
-				if (pr.blockedByWalls && !pr.indirect) {
-					if (const auto oc = brd.posToCell(pr.pos)) {
-						const TileKind k = brd.tiles[brd.idx(oc->x, oc->y)].kind;
-						if (k == TileKind::Wall) {
-							const Point ic = brd.posToCell(prev).value_or(*oc);
-							impactAt(pr, ic);
-							hit = true;
-							break;
-						}
-					}
-					else {
-						hit = true; break;
-					}
-				}
-				if (const auto tc = brd.posToCell(pr.pos)) {
-					if (tc->x == pr.targetCell.x && tc->y == pr.targetCell.y) {
-						impactAt(pr, *tc);
-						hit = true;
-						break;
-					}
-				}
-				tracers << Tracer{ prev, pr.pos, TeamColor(pr.owner), 0.0, 0.08 };
-			}
-			if (!hit) {
-				if (!brd.gridRect.intersects(pr.pos)) {
-					// 消滅
-				}
-				else {
-					alive << pr;
-				}
-			}
-		}
+	const int stageBefore = sim.stage;
+	if (KeyLeft.down() || KeyRight.down()) {
+		const uint64 t = replay->tick();
+		replay->seek(sim, KeyRight.down() ? (t + ReplaySeekTicks) : (t > ReplaySeekTicks ? (t - ReplaySeekTicks) : 0));
+		sim.brd.markAllDirty();
+		staticDirty = true;
+		simAccum = 0.0;
+		tracers.clear(); particles.clear(); rings.clear();
 	}
 
-	projectiles.swap(alive);
-}
-
-// 着弾時の効果
-void Game::impactAt(const Projectile& pr, const Point& ic) {
-	if (!brd.inBounds(ic.x, ic.y)) return;
-
-	if (pr.aoeRadius > 0) {
-		applyAOE(ic, pr.aoeRadius, (pr.owner == Team::Blue ? +pr.paint : -pr.paint), pr.damage, pr.owner);
-		SpawnParticles(brd.cellCenter(ic), (pr.owner == Team::Blue ? HSV{ 210,0.8,1.0 } : HSV{ 0,0.8,1.0 }), 18, 140, 260, 0.25, 0.6, 4, 18);
-		Circle{ brd.cellCenter(ic), 16.0 + pr.aoeRadius * brd.tileSize * 0.25 }.drawFrame(3, TeamColor(pr.owner).withAlpha(0.6));
-		AddShake(7.0, 0.12);
-		hitStopTimer = Max(hitStopTimer, 0.02);
+	sim.eventsEnabled = (simSpeed != 0 && simSpeed <= SimFxMaxSpeed);
+	if (simSpeed == 0) {
+		simAccum = 0.0;
+		renderAlpha = 1.0;
+		const Stopwatch sw{ StartImmediately::Yes };
+		while (replay->advance(sim, 1) && sw.sF() < SimMaxSpeedFrameBudget) {}
 	}
 	else {
-		applyPaintAt(ic, (pr.owner == Team::Blue ? +pr.paint : -pr.paint));
-		damageAt(ic, pr.damage, pr.owner);
-		SpawnParticles(brd.cellCenter(ic), (pr.owner == Team::Blue ? HSV{ 210,0.8,1.0 } : HSV{ 0,0.8,1.0 }), 10, 120, 220, 0.20, 0.45, 3, 12);
-		AddShake(3.0, 0.06);
-	}
-}
-
-// ===================== プレイヤー操作・敵AI（体当たり） =====================
-
-bool Game::isWallAt(const Vec2& p) const {
-	if (const auto oc = brd.posToCell(p)) {
-		return (brd.tiles[brd.idx(oc->x, oc->y)].kind == TileKind::Wall);
-	}
-	return true; // 盤面外は壁扱い
-}
-
-void Game::moveWithCollide(Actor& a, const Vec2& delta) {
-	if (!a.alive) return;
-
-	// X方向
-	Vec2 np = a.pos + Vec2{ delta.x, 0 };
-	const double minX = brd.gridRect.x + a.radius;
-	const double maxX = brd.gridRect.x + brd.gridRect.w - a.radius;
-	np.x = Clamp(np.x, minX, maxX);
-	if (!isWallAt(np)) a.pos.x = np.x;
-
-	// Y方向
-	np = a.pos + Vec2{ 0, delta.y };
-	const double minY = brd.gridRect.y + a.radius;
-	const double maxY = brd.gridRect.y + brd.gridRect.h - a.radius;
-	np.y = Clamp(np.y, minY, maxY);
-	if (!isWallAt(np)) a.pos.y = np.y;
-}
-
-// スポナーをクリックで出撃
-bool Game::trySpawnFromClickedSpawner() {
-	if (!MouseL.down()) return false;
-	if (const auto oc = brd.screenToCell(Cursor::PosF())) {
-		const int bi = brd.blueIndex[brd.idx(oc->x, oc->y)];
-		if (bi >= 0) {
-			const Structure& s = blues[bi];
-			if (s.alive && s.type == StructureType::spawner) {
-				spawnPlayerAt(s.cell);
-				SpawnParticles(brd.cellCenter(s.cell), HSV{ 210,0.8,1.0 }, 14, 120, 240, 0.18, 0.35, 3, 12);
-				return true;
+		simAccum += dtReal * simSpeed;
+		const uint64 n = (uint64)(simAccum / SimFixedDt);
+		simAccum -= (n * SimFixedDt);
+		if (replay->advance(sim, Min<uint64>(n, (uint64)(SimMaxStepsPerFrame * simSpeed))) < n) simAccum = 0.0;
+		renderAlpha = (simAccum / SimFixedDt);
+	}
+	phase = replay->phase();
+	if (sim.stage != stageBefore) staticDirty = true;
+
+	consumeSimEvents();
+	updateVisuals(dtReal);
+}
+
+// SimCore の演出イベントを再生
+void Game::consumeSimEvents() {
+	PROFILE_ZONE(ProfZone::ConsumeEvents);
+	for (const auto& e : sim.events) {
+		switch (e.kind) {
+		case SimEventKind::Particles:
+			SpawnParticles(e.p0, e.col, e.count, e.speedMin, e.speedMax, e.lifeMin, e.lifeMax, e.size0, e.size1);
+			break;
+		case SimEventKind::Tracer:
+			tracers.push(Tracer{ e.p0, e.p1, e.col, 0.0, e.lifeMax });
+			break;
+		case SimEventKind::Ring:
+			rings.push(Ring{ e.p0, e.size0, e.col, 0.0, e.lifeMax });
+			break;
+		case SimEventKind::Shake:
+			AddShake(e.power, e.duration);
+			break;
+		case SimEventKind::HitStop:
+			hitStopTimer = Max(hitStopTimer, e.duration);
+			break;
+		case SimEventKind::Sound:
+			switch (e.sound) {
+			case SimSound::ShotBasic:     playSfx(sfxShotBasic, e.volume); break;
+			case SimSound::ShotSprinkler: playSfx(sfxShotSprinkler, e.volume); break;
+			case SimSound::ShotSniper:    playSfx(sfxShotSniper, e.volume); break;
+			case SimSound::ShotMortar:    playSfx(sfxShotMortar, e.volume); break;
 			}
+			break;
 		}
 	}
-	return false;
-}
-
-void Game::spawnPlayerAt(const Point& c) {
-	Actor a;
-	a.pos = brd.cellCenter(c);
-	a.lastPos = a.pos;
-	a.radius = PlayerRadius;
-	a.speed = PlayerSpeed;
-	a.hp = HPPlayer;
-	a.alive = true;
-	a.moveTarget.reset();
-	a.life = PlayerLifetime;
-	a.age = 0.0;
-	player = a;
-}
-
-void Game::playerExplodeAt(const Point& cell) {
-	const Vec2 center = brd.cellCenter(cell);
-	applyAOE(cell, PlayerExplodeRadius, +PlayerExplodePaint, PlayerExplodeDamage, Team::Blue);
-	SpawnParticles(center, HSV{ 210,0.85,1.0 }, 36, 180, 360, 0.30, 0.70, 5, 22);
-	SpawnParticles(center, ColorF{ 1.0, 0.95 }, 18, 120, 260, 0.12, 0.25, 4, 14);
-	AddShake(PlayerExplodeShakePow, PlayerExplodeShakeDur);
-	hitStopTimer = Max(hitStopTimer, PlayerExplodeHitstop);
-	if (player) {
-		player->alive = false;
-	}
-}
-
-// 移動経路のセルを塗る
-void Game::paintTrailByMove(const Vec2& from, const Vec2& to, double dt) {
-	const auto c0 = brd.posToCell(from);
-	const auto c1 = brd.posToCell(to);
-	if (!c0 || !c1) return;
-
-	Array<Point> path = LineCells(*c0, *c1);
-	if (path.isEmpty()) return;
-
-	const double total = PlayerPaintPerSecond * dt;
-	const double per = total / (double)path.size();
-
-	for (const auto& cell : path) {
-		if (brd.inBounds(cell.x, cell.y) && brd.tiles[brd.idx(cell.x, cell.y)].kind != TileKind::Wall) {
-			applyPaintAt(cell, +per);
-		}
-	}
+	sim.events.clear();
 }
 
-// プレイヤー更新
-void Game::updatePlayer(double dt) {
-	const bool spawnedNow = trySpawnFromClickedSpawner();
-
-	if (!player || !player->alive) return;
-
-	if (phase == Phase::Simulating && MouseL.down() && !spawnedNow) {
-		if (const auto oc = brd.screenToCell(Cursor::PosF())) {
-			Point fromC = brd.posToCell(player->pos).value_or(*oc);
-			Point toC = *oc;
-			Point dest = toC;
-			if (brd.tiles[brd.idx(toC.x, toC.y)].kind == TileKind::Wall) {
-				dest = RaycastUntilWall(brd, fromC, toC);
-			}
-			player->moveTarget = brd.cellCenter(dest);
-		}
-	}
-
-	if (player->moveTarget) {
-		Vec2 dir = (*player->moveTarget - player->pos);
-		const double dist = dir.length();
-		const double stepLen = player->speed * dt;
-		Vec2 prev = player->pos;
-		if (dist <= stepLen || dist <= 1e-3) {
-			player->pos = *player->moveTarget;
-			player->moveTarget.reset();
-			paintTrailByMove(prev, player->pos, dt);
-		}
-		else {
-			dir = dir.setLength(stepLen);
-			moveWithCollide(*player, dir);
-			paintTrailByMove(prev, player->pos, dt);
-		}
-	}
-
-	if (const auto oc = brd.posToCell(player->pos)) {
-		const int idxR = brd.redIndex[brd.idx(oc->x, oc->y)];
-		if (idxR >= 0) {
-			playerExplodeAt(*oc);
-			return;
-		}
-	}
+// トレーサー・パーティクル・リングの寿命更新
+void Game::updateVisuals(double dtReal) {
+	PROFILE_ZONE(ProfZone::UpdateVisuals);
+	tracers.update([&](Tracer& t) {
+		t.age += dtReal;
+		return (t.age < t.life);
+		});
 
-	player->age += dt;
-	if (player->life > 0.0 && player->age >= player->life) {
-		SpawnParticles(player->pos, HSV{ 210,0.7,1.0 }, 12, 80, 160, 0.18, 0.36, 3, 12);
-		player->alive = false;
-	}
+	particles.update([&](Particle& p) {
+		p.age += dtReal;
+		p.pos += p.vel * dtReal;
+		p.vel *= 0.98;
+		return (p.age < p.life);
+		});
 
-	player->lastPos = player->pos;
+	rings.update([&](Ring& rg) { rg.age += dtReal; return (rg.age < rg.life); });
 }
 
-// ===== 敵ユニット（AI） =====
-void Game::spawnEnemyAt(const Point& c) {
-	Actor a;
-	a.pos = brd.cellCenter(c);
-	a.lastPos = a.pos;
-	a.radius = EnemyRadius;
-	a.speed = EnemySpeed;
-	a.hp = HPEnemy;
-	a.alive = true;
-	a.moveTarget.reset();
-	a.life = EnemyLifetime;
-	a.age = 0.0;
-	redAgents << a;
-	SpawnParticles(a.pos, HSV{ 0,0.8,1.0 }, 10, 100, 200, 0.15, 0.30, 3, 12);
+// ===================== フェーズ =====================
+void Game::beginSimulation() {
+	recorder.record(simTick, ReplayOp::BeginSim);
+	phase = Phase::Simulating;
+	sim.beginTurn();
+	simAccum = 0.0;
+	skipping = false;
+	tracers.clear();
+	stageStarting = false;
 }
 
-void Game::enemyExplodeAt(const Point& cell) {
-	const Vec2 center = brd.cellCenter(cell);
-	applyAOE(cell, EnemyExplodeRadius, -EnemyExplodePaint, EnemyExplodeDamage, Team::Red);
-	SpawnParticles(center, HSV{ 0,0.85,1.0 }, 28, 160, 320, 0.25, 0.60, 5, 20);
-	AddShake(EnemyExplodeShakePow, EnemyExplodeShakeDur);
-	hitStopTimer = Max(hitStopTimer, EnemyExplodeHitstop);
+void Game::endSimulationAndScore() {
+	sim.endTurnAndScore();
+	recorder.record(simTick, ReplayOp::EndTurn, 0, Point{ 0, 0 }, sim.plannerRoundsLog);
+	consumeSimEvents();
+	phase = Phase::Planning;
 }
 
-Vec2 Game::enemySeekTargetVec(const Actor& e) const {
-	double bestD2 = 1e18;
-	Vec2 best{ 0,0 };
-	for (const auto& s : blues) {
-		if (!s.alive) continue;
-		Vec2 p = brd.cellCenter(s.cell);
-		double d2 = (p - e.pos).lengthSq();
-		if (d2 < bestD2) { bestD2 = d2; best = (p - e.pos); }
+void Game::gotoNextStage() {
+	for (int i = 0; i < 10; ++i) {
+		SpawnParticles(sim.brd.gridRect.center() + RandomVec2(Circle{ sim.brd.gridRect.h * 0.2 }),
+					   HSV{ 120 + Random(-20, 20), 0.8, 1.0 }, 30, 120, 260, 0.4, 0.9, 3, 18);
 	}
-	return best;
+	recorder.record(simTick, ReplayOp::NextStage);
+	sim.gotoNextStage();
+	resetViewForStage();
 }
 
-void Game::updateEnemySpawnerProduction(double dt) {
-	(void)dt;
-	for (auto& s : reds) {
-		if (!s.alive || s.type != StructureType::spawner) continue;
-		while (simElapsed + 1e-6 >= s.nextFire) {
-			spawnEnemyAt(s.cell);
-			s.nextFire += s.interval;
-		}
-	}
-}
-
-void Game::updateRedAgents(double dt) {
-	Array<Actor> stillAlive;
-	stillAlive.reserve(redAgents.size());
-
-	for (auto& e : redAgents) {
-		if (!e.alive) continue;
-
-		e.age += dt;
-		if (e.life > 0.0 && e.age >= e.life) {
-			SpawnParticles(e.pos, HSV{ 0,0.6,1.0 }, 8, 80, 160, 0.15, 0.30, 3, 10);
-			e.alive = false;
-			continue;
-		}
-
-		Vec2 to = enemySeekTargetVec(e);
-		if (to.lengthSq() > 1e-4) {
-			Vec2 step = to.setLength(e.speed * dt);
-			moveWithCollide(e, step);
-		}
-
-		bool exploded = false;
-		if (const auto oc = brd.posToCell(e.pos)) {
-			const int idxB = brd.blueIndex[brd.idx(oc->x, oc->y)];
-			if (idxB >= 0) {
-				enemyExplodeAt(*oc);
-				e.alive = false;
-				exploded = true;
-			}
-		}
-
-		if (e.alive && !exploded) {
-			stillAlive << e;
-		}
-	}
-
-	redAgents.swap(stillAlive);
+void Game::retryStage() {
+	recorder.record(simTick, ReplayOp::Retry);
+	buildMapForStage(sim.stage);
 }
 
 // シミュレーション更新
 void Game::updateSimulation(double dtReal) {
+	PROFILE_ZONE(ProfZone::UpdateSimulation);
+	// ショートカット：[F] 速度切り替え
+	if (KeyF.down()) cycleSimSpeed();
+
 	if (hitStopTimer > 0.0) { hitStopTimer -= dtReal; timeScale = (hitStopTimer <= 0.0 ? 1.0 : 0.0); }
 	else { timeScale = 1.0; }
 	const double dt = dtReal * timeScale;
 
-	simElapsed += dt;
-	simTime -= dt;
-	if (simTime <= 0.0) {
-		simTime = 0.0;
-		phase = Phase::Summary;
-		stageCleared = isBlueWin() && !isBlueLose();
-		clearShakeAndHitStop();
-	}
-
-	// まずは狙い方向の推定と回転補間
-	updateTurretAim(dt);
-
-	// 発射スケジュール
-	auto stepFire = [&](Array<Structure>& a, Team atk) {
-		for (auto& s : a) {
-			if (!s.alive) continue;
-			const TypeSpec& spec = GetSpec(s.type);
-			if (spec.shots <= 0) continue;
-			while (simElapsed + 1e-6 >= s.nextFire) {
-				fireOnce(s, atk);
-				s.nextFire += s.interval;
+	// 入力：スポナーをクリックで出撃 / それ以外は移動先指定
+	if (MouseL.down()) {
+		if (const auto oc = cursorCell()) {
+			recorder.record(simTick, ReplayOp::Move, 0, *oc);
+			if (!sim.spawnFromSpawner(*oc)) {
+				sim.commandPlayerMove(*oc);
 			}
 		}
-		};
-	stepFire(blues, Team::Blue);
-	stepFire(reds, Team::Red);
-
-	// 実弾・トレーサー・パーティクル
-	updateProjectiles(dt);
-
-	// 敵スポナー出撃
-	// updateEnemySpawnerProduction(dt);
-
-	// 敵ユニット
-	updateRedAgents(dt);
-
-	// プレイヤー
-	updatePlayer(dt);
-
-	Array<Tracer> aliveT;
-	for (auto& t : tracers) {
-		t.age += dtReal;
-		if (t.age < t.life) aliveT << t;
 	}
-	tracers.swap(aliveT);
 
-	Array<Particle> aliveP;
-	for (auto& p : particles) {
-		p.age += dtReal;
-		p.pos += p.vel * dtReal;
-		p.vel *= 0.98;
-		if (p.age < p.life) aliveP << p;
-	}
-	particles.swap(aliveP);
+	const bool finished = advanceSim(dt);
+	consumeSimEvents();
 
-	// HQ 勝敗判定（中断）
-	if (isBlueLose()) {
-		phase = Phase::Summary;
-		stageCleared = false;
-		clearShakeAndHitStop();
-	}
-	else if (isBlueWin()) {
+	updateVisuals(dtReal);
+
+	if (finished) {
 		phase = Phase::Summary;
-		stageCleared = true;
+		stageCleared = sim.isBlueWin() && !sim.isBlueLose();
+		skipping = false;
+		sim.eventsEnabled = true;
 		clearShakeAndHitStop();
 	}
 }
 
 // サマリー->次ターン or 次ステージ
 void Game::updateSummary() {
-	const double panelY = brd.gridRect.y + brd.gridRect.h * 0.60;
-	const RectF panel{ brd.gridRect.x, panelY, brd.gridRect.w, 160 };
+	const double panelY = viewRect.y + viewRect.h * 0.60;
+	const RectF panel{ viewRect.x, panelY, viewRect.w, 160 };
 	panel.draw(ColorF{ 0,0,0,0.6 });
 	panel.drawFrame(2, ColorF{ 0,0,0,0.8 });
 
 	String msg;
-	if (isBlueLose())       msg = U"敗北…";
-	else if (isBlueWin())   msg = U"ステージクリア！";
-	else                    msg = U"ターン終了";
+	if (sim.isBlueLose())       msg = U"敗北…";
+	else if (sim.isBlueWin())   msg = U"ステージクリア！";
+	else                        msg = U"ターン終了";
 
 	FontAsset(U"UI")(U"結果: {}"_fmt(msg)).drawAt(32, panel.center().movedBy(0, -36), ColorF{ 1 });
 	const bool enter = KeyEnter.down();
 
-	if (isBlueWin()) {
+	if (sim.isBlueWin()) {
 		const bool clicked = SimpleGUI::Button(U"次のステージへ [Enter]", Vec2{ panel.center().x - 160, panel.center().y - 10 }, 220);
-		if (clicked || enter) { if (sfxUIButton) sfxUIButton.playOneShot(0.8); gotoNextStage(); return; }
+		if (clicked || enter) { playSfx(sfxUIButton, 0.8); gotoNextStage(); return; }
 	}
-	else if (isBlueLose()) {
+	else if (sim.isBlueLose()) {
 		const bool clicked = SimpleGUI::Button(U"ステージ再挑戦 [Enter]", Vec2{ panel.center().x - 120, panel.center().y - 10 }, 240);
-		if (clicked || enter) { if (sfxUIButton) sfxUIButton.playOneShot(0.8); buildMapForStage(stage); return; }
+		if (clicked || enter) { playSfx(sfxUIButton, 0.8); retryStage(); return; }
 	}
 	else {
 		const bool clicked = SimpleGUI::Button(U"次ターンへ（収益計算） [Enter]", Vec2{ panel.center().x - 160, panel.center().y - 10 }, 320);
-		if (clicked || enter) { if (sfxUIButton) sfxUIButton.playOneShot(0.8); endSimulationAndScore(); return; }
+		if (clicked || enter) { playSfx(sfxUIButton, 0.8); endSimulationAndScore(); return; }
 	}
 	FontAsset(U"UI")(U"Enter ですすむ / クリックでも可").drawAt(20, panel.center().movedBy(0, 36), ColorF{ 0.95 });
 }
 
 // 入力（プランニング）
 void Game::updatePlanning() {
-	if (trySpawnFromClickedSpawner()) {
-		// 出撃クリックの場合は配置処理をスキップ
-	}
-	else if (MouseL.down()) {
-		if (const auto oc = brd.screenToCell(Cursor::PosF())) {
-			String reason;
-			if (canPlace(Team::Blue, selectedType, *oc, reason)) {
-				placeBlue(selectedType, *oc);
-				SpawnParticles(brd.cellCenter(*oc), HSV{ 210,0.8,1.0 }, 10, 90, 180, 0.2, 0.45, 2, 10);
+	PROFILE_ZONE(ProfZone::UpdatePlanning);
+	if (MouseL.down()) {
+		if (const auto oc = cursorCell()) {
+			if (sim.spawnFromSpawner(*oc)) {
+				// 出撃クリックの場合は配置処理をスキップ
+				recorder.record(simTick, ReplayOp::Spawn, 0, *oc);
+			}
+			else if (sim.placeBlue(selectedType, *oc)) {
+				recorder.record(simTick, ReplayOp::Place, (int32)selectedType, *oc);
+				SpawnParticles(sim.brd.cellCenter(*oc), HSV{ 210,0.8,1.0 }, 10, 90, 180, 0.2, 0.45, 2, 10);
 			}
 		}
 	}
 
+	// [V] 置ける場所の表示切り替え
+	if (KeyV.down()) showPlacementMap = !showPlacementMap;
+
 	if (KeyEnter.down()) {
 		beginSimulation();
 	}
 
-	updatePlayer(Scene::DeltaTime());
+	advanceSim(Scene::DeltaTime());
+	consumeSimEvents();
 
 	if (stageStarting) {
 		stageBannerT = Min(1.0, stageBannerT + Scene::DeltaTime() / 1.2);
 	}
 }
 
-// 置けるか判定
-bool Game::canPlace(Team side, StructureType type, const Point& c, String& reason) const {
-	if (!brd.inBounds(c.x, c.y)) { reason = U"範囲外"; return false; }
-	const Tile& t = brd.tiles[brd.idx(c.x, c.y)];
-	if (t.kind != TileKind::Floor) { reason = U"ここには置けません"; return false; }
+// ===================== 描画 =====================
+void Game::updateBoardLayers() {
+	PROFILE_ZONE(ProfZone::UpdateBoardLayers);
+	Board& b = sim.brd;
 
-	if (side == Team::Blue) {
-		if (brd.blueIndex[brd.idx(c.x, c.y)] != -1) { reason = U"味方構造物あり"; return false; }
-		if (brd.redIndex[brd.idx(c.x, c.y)] != -1) { reason = U"敵構造物あり"; return false; }
-	}
-	else {
-		if (brd.redIndex[brd.idx(c.x, c.y)] != -1) { reason = U"自軍構造物あり"; return false; }
-		if (brd.blueIndex[brd.idx(c.x, c.y)] != -1) { reason = U"敵構造物あり"; return false; }
+	// 盤面の大きさが変わったら作り直す（Board::init で全チャンクが dirty になっている）
+	if ((int)paintImage.width() != b.w || (int)paintImage.height() != b.h) {
+		paintImage = Image{ (size_t)b.w, (size_t)b.h, Color{ 255 } };
+		paintTex = DynamicTexture{};
+		staticDirty = true;
 	}
 
-	const bool own = (side == Team::Blue ? (t.paint > 0.55f) : (t.paint < 0.45f));
-	if (!own) { reason = U"自軍インク外"; return false; }
-
-	const int cost = GetSpec(type).cost;
-	if (side == Team::Blue) {
-		if (moneyBlue < cost) { reason = U"$不足"; return false; }
+	// 塗りが変わったチャンクだけ色を計算し直す
+	bool changed = false;
+	for (int cy = 0; cy < b.chunksY; ++cy) {
+		for (int cx = 0; cx < b.chunksX; ++cx) {
+			if (!b.chunkDirty[cy * b.chunksX + cx]) continue;
+			b.forEachCellInChunk(cx, cy, [&](int x, int y, int i) {
+				paintImage[y][x] = PaintColor(b.paint[i]);
+				});
+			changed = true;
+		}
 	}
-	else {
-		if (moneyRed < cost) { reason = U"$不足(敵)"; return false; }
+	b.clearDirty();
+
+	if (changed || !paintTex) {
+		if (!paintTex) paintTex = DynamicTexture{ paintImage };
+		else paintTex.fill(paintImage);
 	}
 
-	reason = U"OK";
-	return true;
+	if (staticDirty) {
+		drawStaticLayer();
+		staticDirty = false;
+	}
 }
 
-// プレイヤー設置
-bool Game::placeBlue(StructureType type, const Point& c) {
-	String r; if (!canPlace(Team::Blue, type, c, r)) return false;
-	Structure s; s.owner = Team::Blue; s.type = type; s.cell = c; s.hp = GetSpec(type).maxHP; s.alive = true;
-	blues << s;
-	brd.blueIndex[brd.idx(c.x, c.y)] = (int)blues.size() - 1;
-	moneyBlue -= GetSpec(type).cost;
-	return true;
+// 壁・HQ・グリッド線（変わらない部分）を staticLayer に描く
+void Game::drawStaticLayer() {
+	const Board& b = sim.brd;
+	staticScale = Min(b.tileSize, Max(1.0, Floor((double)BoardStaticLayerMaxPx / Max(b.w, b.h))));
+	const uint32 pw = (uint32)(b.w * staticScale), ph = (uint32)(b.h * staticScale);
+	if (staticLayer.size() != Size{ (int32)pw, (int32)ph }) staticLayer = RenderTexture{ pw, ph };
+
+	const ScopedRenderTarget2D target{ staticLayer.clear(ColorF{ 0.0, 0.0 }) };
+	const ScopedRenderStates2D blend{ BlendState::MaxAlpha };
+	const Transformer2D tr{ Mat3x2::Scale(staticScale / b.tileSize), TransformCursor::No, Transformer2D::Target::SetLocal };
+
+	b.forEachCell([&](int x, int y, int i) {
+		const TileKind kind = b.kind[i];
+		const RectF rc = b.cellRect(Point{ x, y }).movedBy(-b.gridRect.pos);
+		rc.drawFrame(1, ColorF{ 0,0,0,0.15 });
+
+		if (kind == TileKind::Wall) {
+			rc.stretched(-2).draw(ColorF{ 0.12, 0.12, 0.13 });
+		}
+		else if (kind == TileKind::HQBlue) {
+			Circle{ rc.center(), rc.w * 0.38 }.draw(HSV{ 210, 0.6, 1.0 });
+		}
+		else if (kind == TileKind::HQRed) {
+			Circle{ rc.center(), rc.w * 0.38 }.draw(HSV{ 0, 0.6, 1.0 });
+		}
+		});
 }
 
-// ===================== 描画 =====================
 void Game::drawBoard() const {
-	for (int y = 0; y < GH; ++y) {
-		for (int x = 0; x < GW; ++x) {
-			const Tile& t = brd.tiles[brd.idx(x, y)];
-			ColorF color;
-			const double s = (t.paint - 0.5) * 2.0; // -1..1
-			if (s >= 0) color = TeamColor(Team::Blue).lerp(ColorF{ 1.0 }, 1.0 - s);
-			else        color = TeamColor(Team::Red).lerp(ColorF{ 1.0 }, 1.0 - (-s));
-
-			RectF rc = brd.cellRect(Point{ x, y });
-			rc.draw(color);
-			rc.drawFrame(1, ColorF{ 0,0,0,0.15 });
-
-			if (t.kind == TileKind::Wall) {
-				rc.stretched(-2).draw(ColorF{ 0.12, 0.12, 0.13 });
-			}
-			else if (t.kind == TileKind::HQBlue) {
-				Circle{ rc.center(), rc.w * 0.38 }.draw(HSV{ 210, 0.6, 1.0 });
-			}
-			else if (t.kind == TileKind::HQRed) {
-				Circle{ rc.center(), rc.w * 0.38 }.draw(HSV{ 0, 0.6, 1.0 });
-			}
-		}
+	PROFILE_ZONE(ProfZone::DrawBoard);
+	const Board& b = sim.brd;
+	{
+		// 塗り：1タイル = 1テクセルを拡大して1枚で描く
+		const ScopedRenderStates2D sampler{ SamplerState::ClampNearest };
+		paintTex.scaled(b.tileSize).draw(b.gridRect.pos);
 	}
+	staticLayer.scaled(b.tileSize / staticScale).draw(b.gridRect.pos);
 }
 
 void Game::drawStructures() const {
-	auto drawSide = [&](const Array<Structure>& a) {
-		for (const auto& s : a) {
-			if (!s.alive) continue;
-			const RectF rc = brd.cellRect(s.cell).stretched(5);
-			const Vec2 center = rc.center();
-			const ColorF base = (s.owner == Team::Blue ? HSV{ 210,0.9,1.0 } : HSV{ 0,0.9,1.0 });
-
-			// テクスチャ描画（存在しない場合は従来の図形描画にフォールバック）
-			const Texture& tex = GetStructureTexture(s.type);
-			bool drawn = false;
-			if (tex) {
-				// 右向き基準のテクスチャを s.rot で回転して中心描画
-				tex.resized(rc.w, rc.h).rotated(s.rot).drawAt(center, base);
-				drawn = true;
-			}
-
-			if (!drawn) {
-				// フォールバック: 旧シェイプ描画（回転なし）
-				switch (s.type) {
-				case StructureType::Basic:
-					rc.draw(base.withAlpha(0.85));
-					rc.drawFrame(2, ColorF{ 0,0,0,0.65 });
-					break;
-				case StructureType::Sprinkler:
-					Circle{ center, rc.w * 0.32 }.draw(base);
-					Circle{ center, rc.w * 0.50 }.drawFrame(2, base);
-					break;
-				case StructureType::Pump:
-					Triangle{ center, rc.w * 0.9, 0_deg }.draw(base);
-					break;
-				case StructureType::Sniper:
-					RectF{ Arg::center = center, rc.w * 0.9, rc.h * 0.55 }.draw(base);
-					break;
-				case StructureType::Mortar:
-					Circle{ center, rc.w * 0.42 }.draw(base);
-					RectF{ Arg::center = center.movedBy(0, -rc.h * 0.15), rc.w * 0.28, rc.h * 0.35 }.draw(ColorF{ 0 });
-					break;
-				case StructureType::HQ:
-					Circle{ center, rc.w * 0.60 }.drawFrame(3, base);
-					break;
-				case StructureType::spawner:
-					// スポナーが残っている場合のフォールバック
-					Circle{ center, rc.w * 0.36 }.draw(base);
-					break;
-				}
+	PROFILE_ZONE(ProfZone::DrawStructures);
+	for (const auto& s : sim.structures) {
+		const RectF rc = sim.brd.cellRect(s.cell).stretched(5);
+		const Vec2 center = rc.center();
+		const ColorF base = (s.owner == Team::Blue ? HSV{ 210,0.9,1.0 } : HSV{ 0,0.9,1.0 });
+
+		// テクスチャ描画（存在しない場合は従来の図形描画にフォールバック）
+		const Texture& tex = assets.get(texStructures[Min((size_t)s.type, texStructures.size() - 1)]);
+		bool drawn = false;
+		if (tex) {
+			// 右向き基準のテクスチャを s.rot で回転して中心描画
+			tex.resized(rc.w, rc.h).rotated(s.rot).drawAt(center, base);
+			drawn = true;
+		}
+
+		if (!drawn) {
+			// フォールバック: 旧シェイプ描画（回転なし）
+			switch (s.type) {
+			case StructureType::Basic:
+				rc.draw(base.withAlpha(0.85));
+				rc.drawFrame(2, ColorF{ 0,0,0,0.65 });
+				break;
+			case StructureType::Sprinkler:
+				Circle{ center, rc.w * 0.32 }.draw(base);
+				Circle{ center, rc.w * 0.50 }.drawFrame(2, base);
+				break;
+			case StructureType::Pump:
+				Triangle{ center, rc.w * 0.9, 0_deg }.draw(base);
+				break;
+			case StructureType::Sniper:
+				RectF{ Arg::center = center, rc.w * 0.9, rc.h * 0.55 }.draw(base);
+				break;
+			case StructureType::Mortar:
+				Circle{ center, rc.w * 0.42 }.draw(base);
+				RectF{ Arg::center = center.movedBy(0, -rc.h * 0.15), rc.w * 0.28, rc.h * 0.35 }.draw(ColorF{ 0 });
+				break;
+			case StructureType::HQ:
+				Circle{ center, rc.w * 0.60 }.drawFrame(3, base);
+				break;
+			case StructureType::spawner:
+				// スポナーが残っている場合のフォールバック
+				Circle{ center, rc.w * 0.36 }.draw(base);
+				break;
 			}
+		}
 
-			// HPバー
-			const double maxHP = GetSpec(s.type).maxHP;
-			if (maxHP > 0.0 && s.type != StructureType::HQ) {
-				const double rr = Clamp(s.hp / maxHP, 0.0, 1.0);
-				const RectF hb{ rc.x, rc.y - 6, rc.w, 4 };
-				hb.draw(ColorF{ 0,0,0,0.5 });
-				RectF{ hb.pos, hb.w * rr, hb.h }.draw((s.owner == Team::Blue) ? ColorF{ 0.2,0.9,0.3 } : ColorF{ 0.9,0.2,0.2 });
-			}
+		// HPバー
+		const double maxHP = sim.params.spec(s.type).maxHP;
+		if (maxHP > 0.0 && s.type != StructureType::HQ) {
+			const double rr = Clamp(s.hp / maxHP, 0.0, 1.0);
+			const RectF hb{ rc.x, rc.y - 6, rc.w, 4 };
+			hb.draw(ColorF{ 0,0,0,0.5 });
+			RectF{ hb.pos, hb.w * rr, hb.h }.draw((s.owner == Team::Blue) ? ColorF{ 0.2,0.9,0.3 } : ColorF{ 0.9,0.2,0.2 });
 		}
-		};
-	drawSide(blues);
-	drawSide(reds);
+	}
 }
 
 void Game::drawTracers() const {
-	for (const auto& t : tracers) {
+	PROFILE_ZONE(ProfZone::DrawTracers);
+	tracers.each([](const Tracer& t) {
 		const double a = 1.0 - (t.age / t.life);
 		Line{ t.p0, t.p1 }.draw(4, t.col.withAlpha(0.35 * a));
 		Line{ t.p0, t.p1 }.draw(2, ColorF{ 1.0, a * 0.8 });
-	}
+		});
 }
 
 void Game::drawParticles() const {
-	for (const auto& p : particles) {
+	PROFILE_ZONE(ProfZone::DrawParticles);
+	particles.each([](const Particle& p) {
 		const double t = p.age / p.life;
 		const double r = p.size0 + (p.size1 - p.size0) * t;
 		const double a = 1.0 - t;
 		Circle{ p.pos, r }.draw(p.col.withAlpha(0.6 * a));
-	}
+		});
+	rings.each([](const Ring& rg) {
+		const double a = 1.0 - (rg.age / rg.life);
+		Circle{ rg.pos, rg.radius }.drawFrame(3, rg.col.withAlpha(rg.col.a * a));
+		});
 }
 
 void Game::drawProjectiles() const {
-	for (const auto& pr : projectiles) {
-		ColorF c = TeamColor(pr.owner);
-		if (pr.kind == ProjKind::Sniper) {
-			Circle{ pr.pos, pr.radius * 0.8 }.draw(ColorF{ 1.0, 0.95 });
-			Circle{ pr.pos, pr.radius * 1.6 }.drawFrame(2, c.withAlpha(0.8));
-		}
-		else if (pr.kind == ProjKind::Mortar) {
-			Circle{ pr.pos, pr.radius }.draw(c.withAlpha(0.9));
-			Circle{ pr.pos, pr.radius * 1.6 }.drawFrame(2, ColorF{ 0,0,0,0.35 });
+	PROFILE_ZONE(ProfZone::DrawProjectiles);
+	const StraightProjectiles& st = sim.projectiles.straight;
+	for (size_t i = 0; i < st.size(); ++i) {
+		const Vec2 pos = st.prevPos[i].lerp(st.pos[i], renderAlpha);
+		const double radius = st.radius[i];
+		ColorF c = TeamColor(st.owner[i]);
+		if (st.kind[i] == ProjKind::Sniper) {
+			Circle{ pos, radius * 0.8 }.draw(ColorF{ 1.0, 0.95 });
+			Circle{ pos, radius * 1.6 }.drawFrame(2, c.withAlpha(0.8));
 		}
 		else {
-			Circle{ pr.pos, pr.radius }.draw(c);
+			Circle{ pos, radius }.draw(c);
 		}
 	}
+
+	// 迫撃砲
+	const ArcProjectiles& arcs = sim.projectiles.arcs;
+	for (size_t i = 0; i < arcs.size(); ++i) {
+		const Vec2 pos = arcs.prevPos[i].lerp(arcs.pos[i], renderAlpha);
+		const double radius = arcs.radius[i];
+		ColorF c = TeamColor(arcs.owner[i]);
+		Circle{ pos, radius }.draw(c.withAlpha(0.9));
+		Circle{ pos, radius * 1.6 }.drawFrame(2, ColorF{ 0,0,0,0.35 });
+	}
 }
 
 // プレイヤー描画
 void Game::drawPlayer() const {
-	if (player && player->alive) {
-		Circle{ player->pos, player->radius }.draw(HSV{ 210, 0.9, 1.0 });
-		Circle{ player->pos, player->radius + 3 }.drawFrame(2, ColorF{ 1,1,1,0.6 });
-
-		if (player->moveTarget) {
-			Circle{ *player->moveTarget, 6 }.drawFrame(2, ColorF{ 1,1,1,0.6 });
+	PROFILE_ZONE(ProfZone::DrawActors);
+	if (sim.player && sim.player->alive) {
+		const Vec2 pos = sim.player->prevPos.lerp(sim.player->pos, renderAlpha);
+		Circle{ pos, sim.player->radius }.draw(HSV{ 210, 0.9, 1.0 });
+		Circle{ pos, sim.player->radius + 3 }.drawFrame(2, ColorF{ 1,1,1,0.6 });
+
+		if (sim.player->moveTarget) {
+			// 残りの経路
+			Vec2 from = pos;
+			for (size_t i = sim.player->pathNext; i < sim.player->path.size(); ++i) {
+				Line{ from, sim.player->path[i] }.draw(2, ColorF{ 1,1,1,0.35 });
+				from = sim.player->path[i];
+			}
+			Line{ from, *sim.player->moveTarget }.draw(2, ColorF{ 1,1,1,0.35 });
+			Circle{ *sim.player->moveTarget, 6 }.drawFrame(2, ColorF{ 1,1,1,0.6 });
 		}
 	}
 }
 
 // 敵ユニット描画
 void Game::drawEnemies() const {
-	for (const auto& e : redAgents) {
+	PROFILE_ZONE(ProfZone::DrawActors);
+	for (const auto& e : sim.redAgents) {
 		if (!e.alive) continue;
-		Circle{ e.pos, e.radius }.draw(HSV{ 0, 0.9, 1.0 });
-		Circle{ e.pos, e.radius + 2 }.drawFrame(2, ColorF{ 0,0,0,0.6 });
+		const Vec2 pos = e.prevPos.lerp(e.pos, renderAlpha);
+		Circle{ pos, e.radius }.draw(HSV{ 0, 0.9, 1.0 });
+		Circle{ pos, e.radius + 2 }.drawFrame(2, ColorF{ 0,0,0,0.6 });
 	}
 }
 
 // UI（選択ボタンで selectedType を変更するため非const）
 void Game::drawUI() {
+	PROFILE_ZONE(ProfZone::DrawUI);
 	const RectF ui{ Scene::Width() - UIWidth + Margin * 0.5, Margin, UIWidth - Margin * 1.5, Scene::Height() - 2 * Margin };
 	ui.draw(ColorF{ 0,0,0,0.25 });
 	ui.drawFrame(2, ColorF{ 0,0,0,0.4 });
@@ -1368,12 +836,12 @@ void Game::drawUI() {
 		(phase == Phase::Planning) ? U"フェーズ: 設置" :
 		(phase == Phase::Simulating) ? U"フェーズ: 自動戦闘" : U"フェーズ: 結果";
 	FontAsset(U"UI")(U"浸食！インクウォーズ").draw(24, Vec2{ ui.x + 14, ui.y + 10 }, ColorF{ 1 });
-	FontAsset(U"UI")(U"ステージ {}"_fmt(stage)).draw(20, Vec2{ ui.x + 14, ui.y + 42 }, ColorF{ 1 });
+	FontAsset(U"UI")(U"ステージ {}"_fmt(sim.stage)).draw(20, Vec2{ ui.x + 14, ui.y + 42 }, ColorF{ 1 });
 	FontAsset(U"UI")(ph).draw(18, Vec2{ ui.x + 14, ui.y + 68 }, ColorF{ 1 });
 
-	FontAsset(U"UI")(U"Blue $: {}"_fmt(moneyBlue)).draw(20, Vec2{ ui.x + 14, ui.y + 92 }, ColorF{ 1 });
+	FontAsset(U"UI")(U"Blue $: {}"_fmt(sim.moneyBlue)).draw(20, Vec2{ ui.x + 14, ui.y + 92 }, ColorF{ 1 });
 
-	auto [bp, rp] = Ownership(brd);
+	auto [bp, rp] = Ownership(sim.brd);
 	RectF rbb{ ui.x + 14, ui.y + 120, ui.w - 28, 14 };
 	rbb.draw(ColorF{ 0,0,0,0.3 });
 	RectF{ rbb.pos, rbb.w * (bp < 0.0 ? 0.0 : (bp > 1.0 ? 1.0 : bp)), rbb.h }.draw(HSV{ 210,0.8,1.0 });
@@ -1397,12 +865,16 @@ void Game::drawUI() {
 	drawButton(U"迫撃砲", StructureType::Mortar, y += 42, CostMortar);
 
 	y += 60;
-	if (phase == Phase::Planning) {
+	if (replay) {
+		FontAsset(U"UI")(U"REPLAY {:.1f}s / {:.1f}s（{}）"_fmt(replay->tick() * SimFixedDt, replay->endTick() * SimFixedDt, (replay->isFinished() ? U"終了" : simSpeedLabel()))).draw(18, Vec2{ ui.x + 14, y }, ColorF{ 1, 1, 0.8 });
+		FontAsset(U"UI")(U"[F] 速度 / [←][→] 5秒戻る・進む / [F6] 試合に戻る").draw(16, Vec2{ ui.x + 14, y + 24 }, ColorF{ 0.95 });
+	}
+	else if (phase == Phase::Planning) {
 		FontAsset(U"UI")(U"[Click] 置く / スポナー[Click]出撃 / [Enter] 自動戦闘 10s").draw(18, Vec2{ ui.x + 14, y }, ColorF{ 0.95 });
-		FontAsset(U"UI")(U"[WASD] で移動して塗る / 敵はAIでスポーンし体当たり").draw(16, Vec2{ ui.x + 14, y + 24 }, ColorF{ 0.95 });
+		FontAsset(U"UI")(U"[WASD] で移動して塗る / [V] 置ける場所の表示").draw(16, Vec2{ ui.x + 14, y + 24 }, ColorF{ 0.95 });
 	}
 	else if (phase == Phase::Simulating) {
-		FontAsset(U"UI")(U"自動戦闘中… 残り {:.1f}s"_fmt(simTime)).draw(18, Vec2{ ui.x + 14, y }, ColorF{ 0.95 });
+		FontAsset(U"UI")(U"自動戦闘中… 残り {:.1f}s（{}）"_fmt(sim.simTime, (skipping ? U"スキップ中" : simSpeedLabel()))).draw(18, Vec2{ ui.x + 14, y }, ColorF{ 0.95 });
 		FontAsset(U"UI")(U"敵はスポナーから定期出撃 → Blue構造物へ体当たり").draw(16, Vec2{ ui.x + 14, y + 24 }, ColorF{ 0.95 });
 	}
 	else {
@@ -1410,35 +882,49 @@ void Game::drawUI() {
 	}
 
 	y += 48;
-	FontAsset(U"UI")(U"ターン {}"_fmt(turnCount)).draw(20, Vec2{ ui.x + 14, y }, ColorF{ 1 });
+	FontAsset(U"UI")(U"ターン {}"_fmt(sim.turnCount)).draw(20, Vec2{ ui.x + 14, y }, ColorF{ 1 });
 
-	if (player && player->alive) {
-		FontAsset(U"UI")(U"Player HP: {:.0f}/{}"_fmt(player->hp, HPPlayer)).draw(18, Vec2{ ui.x + 14, y + 26 }, ColorF{ 1 });
+	if (sim.player && sim.player->alive) {
+		FontAsset(U"UI")(U"Player HP: {:.0f}/{}"_fmt(sim.player->hp, HPPlayer)).draw(18, Vec2{ ui.x + 14, y + 26 }, ColorF{ 1 });
 	}
-	FontAsset(U"UI")(U"敵ユニット数: {}"_fmt(redAgents.count_if([](const Actor& a) { return a.alive; }))).draw(18, Vec2{ ui.x + 14, y + 50 }, ColorF{ 1 });
+	FontAsset(U"UI")(U"敵ユニット数: {}"_fmt(sim.redAgents.count_if([](const Actor& a) { return a.alive; }))).draw(18, Vec2{ ui.x + 14, y + 50 }, ColorF{ 1 });
+
+	// 演出バッファの使用量（現在 / 最大同時 / 上限）
+	FontAsset(U"UI")(U"FX P {}/{}/{}  T {}/{}/{}  R {}/{}/{}"_fmt(
+		particles.size(), particles.peak(), particles.capacity(),
+		tracers.size(), tracers.peak(), tracers.capacity(),
+		rings.size(), rings.peak(), rings.capacity())).draw(14, Vec2{ ui.x + 14, y + 76 }, ColorF{ 1, 0.6 });
 }
 
 void Game::drawHoverHelp() const {
 	if (phase != Phase::Planning) return;
-	if (const auto oc = brd.screenToCell(Cursor::PosF())) {
+	const Transformer2D _tr(boardTransform(), TransformCursor::No);
+
+	// 選択中の種類を置けるセル（お金が足りなければ出さない）
+	if (showPlacementMap && sim.moneyBlue >= sim.params.spec(selectedType).cost) {
+		sim.placement.forEach(Team::Blue, [&](const Point& c) {
+			sim.brd.cellRect(c).stretched(-3).draw(ColorF{ 0.3, 1.0, 0.5, 0.16 });
+			});
+	}
+
+	if (const auto oc = cursorCell()) {
 		const Point c = *oc;
-		const RectF rc = brd.cellRect(c).stretched(-2);
+		const RectF rc = sim.brd.cellRect(c).stretched(-2);
 
-		const int bi = brd.blueIndex[brd.idx(c.x, c.y)];
-		if (bi >= 0 && blues[bi].alive && blues[bi].type == StructureType::spawner) {
+		const Structure* s = sim.structures.get(sim.brd.blueIndex[sim.brd.idx(c.x, c.y)]);
+		if (s && s->type == StructureType::spawner) {
 			rc.drawFrame(3, ColorF{ 0.2,0.9,0.4,0.9 });
 			FontAsset(U"UI")(U"[Click] 出撃").draw(16, rc.pos.movedBy(2, 2), ColorF{ 1 });
 			return;
 		}
 
-		String reason;
-		const bool ok = canPlace(Team::Blue, selectedType, c, reason);
+		const bool ok = sim.isPlaceable(Team::Blue, selectedType, c);
 		rc.drawFrame(3, ok ? ColorF{ 0.2,0.9,0.4,0.9 } : ColorF{ 0.9,0.2,0.2, 0.9 });
 
-		const TypeSpec& sp = GetSpec(selectedType);
+		const TypeSpec& sp = sim.params.spec(selectedType);
 		if (sp.range > 0) {
-			const double r = sp.range * brd.tileSize;
-			Circle{ brd.cellCenter(c), r }.drawFrame(2, ColorF{ 1,1,1,0.25 });
+			const double r = sp.range * sim.brd.tileSize;
+			Circle{ sim.brd.cellCenter(c), r }.drawFrame(2, ColorF{ 1,1,1,0.25 });
 		}
 	}
 }
@@ -1447,9 +933,9 @@ void Game::drawStageBanner() const {
 	if (!stageStarting && phase != Phase::Summary) return;
 	double t = stageStarting ? stageBannerT : 1.0;
 	const double alpha = easeInOutSine(Min(1.0, t));
-	const String text = (phase == Phase::Summary && stageCleared) ? U"STAGE CLEAR!" : U"STAGE " + Format(stage);
-	const Vec2 c = brd.gridRect.center();
-	const double w = brd.gridRect.w * 0.7;
+	const String text = (phase == Phase::Summary && stageCleared) ? U"STAGE CLEAR!" : U"STAGE " + Format(sim.stage);
+	const Vec2 c = viewRect.center();
+	const double w = viewRect.w * 0.7;
 	const double h = 64;
 	const double yOff = (1.0 - easeOutBack(alpha)) * -80.0;
 	const RectF banner{ c.x - w / 2, c.y - h / 2 + yOff, w, h };
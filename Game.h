@@ -6,48 +6,65 @@
 #include "Entities.h"
 #include "Board.h"
 #include "GridUtils.h"
+#include "SimCore.h"
+#include "FxRing.h"
+#include "Replay.h"
+#include "Assets.h"
 
 class Game {
 public:
-	Board brd;
+	// 盤面・構造物・弾・ユニット・経済はすべて SimCore が持つ
+	SimCore sim;
 	Phase phase = Phase::Planning;
 
-	// ステージ
-	int stage = 1;
+	// 試合シード（同じシード・同じ入力なら同じ結果）
+	uint64 matchSeed = 0;
+
+	// 固定ステップ実行（false: 旧来の可変 dt）
+	bool fixedTimestep = true;
+	double simAccum = 0.0;		// 未消化の時間
+	double renderAlpha = 1.0;	// 前ステップ -> 現ステップの描画補間率
+
+	// 自動戦闘の速度（1/2/4/16 倍、0 = 最大）。skipping 中はこのターンの残りを最大速度で回す
+	int simSpeed = 1;
+	bool skipping = false;
+
+	// リプレイ：試合中の入力を記録し、[F5] で保存 / [F6] で再生（再生が終わったら元の試合に戻る）
+	uint64 simTick = 0;			// 試合開始からの固定ステップ数（リプレイの時刻）
+	ReplayRecorder recorder;
+	s3d::Optional<ReplayPlayer> replay;	// 再生中のリプレイ
+	SimCore replaySavedSim;		// 再生前の試合
+	Phase replaySavedPhase = Phase::Planning;
+
+	// ステージ演出
 	bool stageStarting = true;
 	double stageBannerT = 0.0; // 0->1でアニメ
 	bool stageCleared = false;
 
-	// 経済
-	int moneyBlue = 200;
-	int moneyRed = 1040;
-	int turnCount = 1;
-
 	// プレイヤーの選択
 	StructureType selectedType = StructureType::Basic;
+	bool showPlacementMap = true; // 選択中の種類を置けるセルを重ねて表示
+	bool showProfiler = false;    // 区間ごとの処理時間・数・確保回数を重ねて表示
 
-	// 構造物
-	s3d::Array<Structure> blues;
-	s3d::Array<Structure> reds;
+	// テクスチャ・音声（Game より先に GPU / 音声デバイスが閉じないよう Game が持つ）
+	AssetRegistry assets;
 
-	// HQインデックス
-	int blueHQ = -1;
-	int redHQ = -1;
+	// 盤面の画面配置（シミュレーション座標 -> 画面座標）
+	double viewScale = 1.0;
+	s3d::Vec2 viewOffset{ 0, 0 };
+	s3d::RectF viewRect;
 
-	// シミュレーション
-	double simTime = 0.0;
-	double simElapsed = 0.0;
+	// 盤面の描画キャッシュ
+	s3d::Image paintImage;				// 1タイル = 1テクセルの塗り色（変わったチャンクだけ塗り直す）
+	s3d::DynamicTexture paintTex;
+	s3d::RenderTexture staticLayer;		// 壁・HQ・グリッド線（ステージ読み込み時に1回描く）
+	double staticScale = SimTileSize;	// staticLayer の1タイルあたりのピクセル数
+	bool staticDirty = true;
 
-	// プレイヤー
-	s3d::Optional<Actor> player;
-
-	// 敵ユニット（AI）
-	s3d::Array<Actor> redAgents;
-
-	// 視覚演出
-	s3d::Array<Tracer> tracers;
-	s3d::Array<Particle> particles;
-	s3d::Array<Projectile> projectiles;
+	// 視覚演出（容量固定。フレーム中の確保はしない）
+	FxRing<Tracer> tracers{ FxMaxTracers };
+	FxRing<Particle> particles{ FxMaxParticles };
+	FxRing<Ring> rings{ FxMaxRings };
 
 	// 画面振動・ヒットストップ
 	double shakeT = 0.0, shakeDur = 0.0, shakePow = 0.0;
@@ -56,9 +73,17 @@ public:
 public:
 	// レイアウト
 	void layout();
+	s3d::Mat3x2 boardTransform(const s3d::Vec2& shake = s3d::Vec2{ 0, 0 }) const;
+
+	// テクスチャ・効果音を登録して読み込みを始める（タイトル画面に入る前に一度だけ）
+	void registerAssets();
+
+	// 試合開始（シード確定 -> ステージ1）
+	void startMatch(uint64 seed);
 
 	// マップ生成
 	void buildMapForStage(int stageNo);
+	void resetViewForStage();	// sim の盤面を作り直した後に呼ぶ（表示側だけ初期化）
 
 	// 画面シェイク・ヒットストップ
 	void AddShake(double p, double d);
@@ -69,14 +94,27 @@ public:
 	// パーティクル
 	void SpawnParticles(const s3d::Vec2& p, const s3d::ColorF& col, int n, double vmin = 80, double vmax = 180, double lifeMin = 0.25, double lifeMax = 0.6, double s0 = 3, double s1 = 14);
 
-	// 勝敗
-	bool isBlueWin() const;
-	bool isBlueLose() const;
+	// 自動戦闘の速度
+	void cycleSimSpeed();
+	void skipTurn();
+	int effectiveSimSpeed() const;
+	s3d::String simSpeedLabel() const;
+
+	// セーブ・ロード（試合の途中の状態をそのまま保存する）
+	bool quickSave() const;
+	bool quickLoad();
+
+	// リプレイ
+	bool saveReplay() const;
+	bool startReplay();
+	void stopReplay();
+	void updateReplay(double dtReal);
 
 	// フェーズ
 	void beginSimulation();
 	void endSimulationAndScore();
 	void gotoNextStage();
+	void retryStage();
 
 	// シミュレーション更新
 	void updateSimulation(double dtReal);
@@ -85,7 +123,10 @@ public:
 	// サマリー更新
 	void updateSummary();
 
-	// 描画
+	// 盤面の描画キャッシュを更新（boardTransform() の外で、drawBoard() より前に呼ぶ）
+	void updateBoardLayers();
+
+	// 描画（盤面系は boardTransform() の下で呼ぶ）
 	void drawBoard() const;
 	void drawStructures() const;
 	void drawTracers() const;
@@ -97,61 +138,41 @@ public:
 	void drawHoverHelp() const;
 	void drawStageBanner() const;
 
+	// プロファイラ（数は毎フレーム入れる。トレースは profiles/ に書き出す）
+	void updateProfilerCounters() const;
+	void drawProfiler() const;
+	bool saveProfilerTrace() const;
+
 private:
-	// 置けるか判定・設置
-	bool canPlace(Team side, StructureType type, const s3d::Point& c, s3d::String& reason) const;
-	bool placeBlue(StructureType type, const s3d::Point& c);
-
-	// 敵AI 設置
-	void enemyPlaceAI();
-
-	// 塗り・ダメージ
-	void applyPaintAt(const s3d::Point& c, double delta);
-	void damageAt(const s3d::Point& c, double dmg, Team attacker);
-	void applyAOE(const s3d::Point& center, int r, double paintDelta, double dmg, Team atk);
-
-	// 構造物乗っ取り
-	void captureStructureAt(const s3d::Point& c, Team from, Team to);
-
-	// タレットの狙い更新・回転補間
-	void updateTurretAim(double dt);
-
-	// 射撃系
-	s3d::Optional<s3d::Point> findTargetCell(Team atk, const s3d::Point& from, int range, bool turretOnly) const;
-	void spawnProjectile(Team atk, const TypeSpec& spec, const s3d::Vec2& muzzle, const s3d::Point& targetCell, ProjKind k, bool useArc, bool blocked, bool indirect, int aoe, double dmg, double paint, double speed, double radiusPx);
-	void fireOnce(Structure& s, Team atk);
-	void updateProjectiles(double dtReal);
-	void impactAt(const Projectile& pr, const s3d::Point& ic);
-
-	// プレイヤー・敵ユニット
-	bool isWallAt(const s3d::Vec2& p) const;
-	void moveWithCollide(Actor& a, const s3d::Vec2& delta);
-
-	bool trySpawnFromClickedSpawner();
-	void spawnPlayerAt(const s3d::Point& c);
-	void playerExplodeAt(const s3d::Point& cell);
-	void paintTrailByMove(const s3d::Vec2& from, const s3d::Vec2& to, double dt);
-	void updatePlayer(double dt);
-
-	void spawnEnemyAt(const s3d::Point& c);
-	void enemyExplodeAt(const s3d::Point& cell);
-	s3d::Vec2 enemySeekTargetVec(const Actor& e) const;
-	void updateEnemySpawnerProduction(double dt);
-	void updateRedAgents(double dt);
-
-	// ====== Audio ======
-	void initAudio();              // 一度だけロード
-	bool audioReady = false;
+	// カーソル位置のセル（盤面外は none）
+	s3d::Optional<s3d::Point> cursorCell() const;
+
+	// 壁・HQ・グリッド線を staticLayer に描く
+	void drawStaticLayer();
+
+	// シミュレーションを dt だけ進める（true: ターン終了）
+	bool advanceSim(double dt);
+
+	// SimCore が積んだ演出イベントを再生
+	void consumeSimEvents();
+	void updateVisuals(double dtReal);
+
+	// ====== Audio / テクスチャ（中身は assets が持つ） ======
 	bool summarySfxPlayed = false; // サマリーSE多重防止
 
+	// 構造物のテクスチャ（StructureType 順。スポナーは持たない）
+	std::array<TextureHandle, (size_t)StructureType::spawner + 1> texStructures{};
+
 	// 発射音
-	s3d::Audio sfxShotBasic;
-	s3d::Audio sfxShotSprinkler;
-	s3d::Audio sfxShotSniper;
-	s3d::Audio sfxShotMortar;
+	SoundHandle sfxShotBasic;
+	SoundHandle sfxShotSprinkler;
+	SoundHandle sfxShotSniper;
+	SoundHandle sfxShotMortar;
 
 	// 結果SE / UIボタン
-	s3d::Audio sfxStageClear;
-	s3d::Audio sfxGameOver;
-	s3d::Audio sfxUIButton;
+	SoundHandle sfxStageClear;
+	SoundHandle sfxGameOver;
+	SoundHandle sfxUIButton;
+
+	void playSfx(SoundHandle h, double volume) const;
 };
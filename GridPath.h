@@ -0,0 +1,253 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Board.h"
+#include "Config.h"
+
+// ===================== 盤面の経路探索（A* + ジャンプポイント探索） =====================
+// 8方向（斜めは両隣が通れるときだけ）・壁以外を通る。コストは 縦横 10 / 斜め 14、ヒューリスティックは octile 距離。
+// 開けた場所は直線・斜めにまとめて飛ばし（JPS）、曲がり角になりうるセルだけをオープンリストに積む。
+// 縦横の飛び先は壁が変わったときに全セルぶん前計算しておく（斜めに進むたびの縦横の走査を O(1) にする）。
+// 作業用の配列（通行可否・g・親・世代番号・オープンリスト）は使い回し、探索ごとの確保やクリアはしない。
+// 結果は (開始, 目的, Board::wallVersion) をキーにキャッシュする（壁が変われば全部捨てる）。
+class GridPathfinder {
+public:
+	// start -> goal の曲がり角の列（start を含まず goal を含む）。届かなければ none
+	s3d::Optional<s3d::Array<s3d::Point>> find(const Board& brd, const s3d::Point& start, const s3d::Point& goal) {
+		if (!brd.inBounds(start.x, start.y) || !brd.inBounds(goal.x, goal.y)) return s3d::none;
+		if (m_wallVersion != brd.wallVersion || m_w != brd.w || m_h != brd.h) prepare(brd);
+		if (!walkable(goal.x, goal.y)) return s3d::none;
+		if (start == goal) return s3d::Array<s3d::Point>{};
+
+		if (m_cache.size() >= PathCacheMaxEntries) m_cache.clear();
+		const uint64 key = ((uint64)lin(start.x, start.y) << 32) | (uint32)lin(goal.x, goal.y);
+		if (const auto it = m_cache.find(key); it != m_cache.end()) {
+			++m_cacheHits;
+			return it->second;
+		}
+
+		auto path = search(start, goal);
+		if (path) m_cache.emplace(key, *path);
+		return path;
+	}
+
+	// 統計（デバッグ表示用）
+	size_t cacheHits() const noexcept { return m_cacheHits; }
+	size_t searches() const noexcept { return m_searches; }
+	size_t lastExpanded() const noexcept { return m_lastExpanded; }
+
+private:
+	static constexpr int32 CostStraight = 10;
+	static constexpr int32 CostDiagonal = 14;
+
+	struct Open {
+		int32 f, g;
+		int32 x, y;
+	};
+	// f が小さい順。同じなら g が大きい（目的に近い）方を先に
+	static bool worse(const Open& a, const Open& b) noexcept {
+		return (a.f != b.f ? (a.f > b.f) : (a.g < b.g));
+	}
+
+	// 以下の配列は y * w + x 順（チャンク順ではない）
+	int m_w = 0, m_h = 0;
+	uint32 m_wallVersion = 0;
+	s3d::Array<uint8> m_walk;		// 通れるか
+	s3d::Array<int32> m_straight[4];	// 縦横の飛び先（+x, -x, +y, -y）。> 0: その歩数先が分岐点 / <= 0: 分岐点なし（-値 = 壁までに進める歩数）
+	s3d::Array<int32> m_g;
+	s3d::Array<int32> m_parent;		// 親のジャンプポイント（-1 = 開始点）
+	s3d::Array<uint32> m_stamp;		// m_generation と同じなら m_g / m_parent が今回の値
+	uint32 m_generation = 0;
+	s3d::Array<Open> m_open;
+	s3d::Point m_goal{ 0, 0 };
+
+	s3d::HashTable<uint64, s3d::Array<s3d::Point>> m_cache;
+
+	size_t m_cacheHits = 0, m_searches = 0, m_lastExpanded = 0;
+
+	int32 lin(int x, int y) const noexcept { return (y * m_w + x); }
+	bool walkable(int x, int y) const noexcept {
+		return (0 <= x && x < m_w && 0 <= y && y < m_h && m_walk[lin(x, y)]);
+	}
+
+	// 壁が変わったら（盤面の作り直しを含む）通行可否を写し直し、キャッシュを捨てる
+	void prepare(const Board& brd) {
+		m_w = brd.w; m_h = brd.h;
+		m_wallVersion = brd.wallVersion;
+		const size_t n = (size_t)m_w * m_h;
+		m_walk.assign(n, 0);
+		brd.forEachCell([&](int x, int y, int i) { m_walk[lin(x, y)] = (brd.kind[i] != TileKind::Wall); });
+		buildStraightJumps();
+		m_g.assign(n, 0);
+		m_parent.assign(n, -1);
+		m_stamp.assign(n, 0);
+		m_generation = 0;
+		m_cache.clear();
+	}
+
+	static int32 octile(int x0, int y0, int x1, int y1) noexcept {
+		const int32 dx = s3d::Abs(x0 - x1), dy = s3d::Abs(y0 - y1);
+		return (CostStraight * s3d::Max(dx, dy) + (CostDiagonal - CostStraight) * s3d::Min(dx, dy));
+	}
+
+	// 分岐点（隣が壁で、その先に回り込めるセル）か。(dx, dy) は縦横の進行方向
+	bool isForced(int x, int y, int dx, int dy) const noexcept {
+		if (dx != 0) return ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) || (walkable(x, y + 1) && !walkable(x - dx, y + 1)));
+		return ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) || (walkable(x + 1, y) && !walkable(x + 1, y - dy)));
+	}
+
+	static int straightIndex(int dx, int dy) noexcept {
+		return (dx > 0 ? 0 : (dx < 0 ? 1 : (dy > 0 ? 2 : 3)));
+	}
+
+	// 各セルから縦横に進んだときの最初の分岐点（または壁）までの歩数を、進行方向の逆から積み上げる
+	void buildStraightJumps() {
+		static constexpr s3d::Point Dirs[4] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+		for (int k = 0; k < 4; ++k) {
+			const int dx = Dirs[k].x, dy = Dirs[k].y;
+			auto& t = m_straight[k];
+			t.assign(m_walk.size(), 0);
+			const int lines = (dx != 0 ? m_h : m_w), len = (dx != 0 ? m_w : m_h);
+			for (int l = 0; l < lines; ++l) {
+				for (int s = len - 1; s >= 0; --s) {
+					const int along = ((dx + dy) > 0 ? s : (len - 1 - s));
+					const int x = (dx != 0 ? along : l), y = (dx != 0 ? l : along);
+					const int nx = x + dx, ny = y + dy;
+					int32& v = t[lin(x, y)];
+					if (!walkable(nx, ny)) v = 0;
+					else if (isForced(nx, ny, dx, dy)) v = 1;
+					else {
+						const int32 next = t[lin(nx, ny)];
+						v = (next > 0 ? next + 1 : next - 1);
+					}
+				}
+			}
+		}
+	}
+
+	// 縦横に進んで最初の分岐点（途中に目的地があればそこ）。壁に当たれば none
+	s3d::Optional<s3d::Point> jumpStraight(int x, int y, int dx, int dy) const {
+		const int32 v = m_straight[straightIndex(dx, dy)][lin(x, y)];
+		const int reach = s3d::Abs(v);
+		const int toGoal = (dx != 0 ? (m_goal.y == y ? (m_goal.x - x) * dx : -1) : (m_goal.x == x ? (m_goal.y - y) * dy : -1));
+		if (0 < toGoal && toGoal <= reach) return m_goal;
+		if (v > 0) return s3d::Point{ x + dx * v, y + dy * v };
+		return s3d::none;
+	}
+
+	// (x, y) から (dx, dy) 方向へ進み、次のジャンプポイントを探す（なければ none）
+	s3d::Optional<s3d::Point> jump(int x, int y, int dx, int dy) const {
+		if (dx == 0 || dy == 0) return jumpStraight(x, y, dx, dy);
+		for (;;) {
+			x += dx; y += dy;
+			if (!walkable(x, y)) return s3d::none;
+			if (x == m_goal.x && y == m_goal.y) return s3d::Point{ x, y };
+			// 縦横どちらかの直進でジャンプポイントが見つかれば、ここが曲がり角
+			if (jumpStraight(x, y, dx, 0) || jumpStraight(x, y, 0, dy)) return s3d::Point{ x, y };
+			if (!(walkable(x + dx, y) && walkable(x, y + dy))) return s3d::none;
+		}
+	}
+
+	// 親からの向きで、調べる価値のある方向だけを列挙（開始点は全方向）
+	template <class Fn>
+	void forEachDirection(int x, int y, int parent, Fn fn) const {
+		if (parent < 0) {
+			for (int dy = -1; dy <= 1; ++dy) for (int dx = -1; dx <= 1; ++dx) {
+				if (dx == 0 && dy == 0) continue;
+				if (dx != 0 && dy != 0 && !(walkable(x + dx, y) && walkable(x, y + dy))) continue;
+				fn(dx, dy);
+			}
+			return;
+		}
+		const int dx = s3d::Clamp(x - (parent % m_w), -1, 1);
+		const int dy = s3d::Clamp(y - (parent / m_w), -1, 1);
+		if (dx != 0 && dy != 0) {
+			const bool h = walkable(x + dx, y), v = walkable(x, y + dy);
+			if (v) fn(0, dy);
+			if (h) fn(dx, 0);
+			if (h && v) fn(dx, dy);
+		}
+		else if (dx != 0) {
+			const bool up = walkable(x, y - 1), down = walkable(x, y + 1);
+			fn(dx, 0);
+			if (walkable(x + dx, y)) {
+				if (up) fn(dx, -1);
+				if (down) fn(dx, 1);
+			}
+			if (up) fn(0, -1);
+			if (down) fn(0, 1);
+		}
+		else {
+			const bool left = walkable(x - 1, y), right = walkable(x + 1, y);
+			fn(0, dy);
+			if (walkable(x, y + dy)) {
+				if (left) fn(-1, dy);
+				if (right) fn(1, dy);
+			}
+			if (left) fn(-1, 0);
+			if (right) fn(1, 0);
+		}
+	}
+
+	s3d::Optional<s3d::Array<s3d::Point>> search(const s3d::Point& start, const s3d::Point& goal) {
+		using namespace s3d;
+		++m_searches;
+		m_lastExpanded = 0;
+		m_goal = goal;
+		if (++m_generation == 0) { // 一周したら印を消す
+			std::fill(m_stamp.begin(), m_stamp.end(), 0u);
+			m_generation = 1;
+		}
+
+		const auto visit = [&](int x, int y, int32 g, int32 parent) {
+			const int i = lin(x, y);
+			if (m_stamp[i] == m_generation && m_g[i] <= g) return;
+			m_stamp[i] = m_generation;
+			m_g[i] = g;
+			m_parent[i] = parent;
+			m_open << Open{ g + octile(x, y, goal.x, goal.y), g, x, y };
+			std::push_heap(m_open.begin(), m_open.end(), worse);
+			};
+
+		m_open.clear();
+		visit(start.x, start.y, 0, -1);
+
+		while (!m_open.isEmpty()) {
+			std::pop_heap(m_open.begin(), m_open.end(), worse);
+			const Open cur = m_open.back();
+			m_open.pop_back();
+
+			const int32 self = lin(cur.x, cur.y);
+			if (cur.g != m_g[self]) continue; // もっと短い経路で見つかり済み
+			if (cur.x == goal.x && cur.y == goal.y) return reconstruct(start, goal);
+			++m_lastExpanded;
+
+			forEachDirection(cur.x, cur.y, m_parent[self], [&](int dx, int dy) {
+				if (const auto jp = jump(cur.x, cur.y, dx, dy)) {
+					visit(jp->x, jp->y, cur.g + octile(cur.x, cur.y, jp->x, jp->y), self);
+				}
+				});
+		}
+		return none;
+	}
+
+	// 親をたどって並べ、同じ向きに続くジャンプポイントは間引く
+	s3d::Array<s3d::Point> reconstruct(const s3d::Point& start, const s3d::Point& goal) const {
+		using namespace s3d;
+		Array<Point> pts;
+		for (Point c = goal; c != start;) {
+			pts << c;
+			const int32 p = m_parent[lin(c.x, c.y)];
+			c = Point{ p % m_w, p / m_w };
+		}
+		pts << start;
+		std::reverse(pts.begin(), pts.end());
+
+		const auto dir = [](const Point& a, const Point& b) { return Point{ Clamp(b.x - a.x, -1, 1), Clamp(b.y - a.y, -1, 1) }; };
+		Array<Point> out;
+		for (size_t i = 1; i < pts.size(); ++i) {
+			const bool last = (i + 1 == pts.size());
+			if (last || dir(pts[i - 1], pts[i]) != dir(pts[i], pts[i + 1])) out << pts[i];
+		}
+		return out;
+	}
+};
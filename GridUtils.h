@@ -5,34 +5,50 @@
 #include "Config.h"
 
 // ===================== ユーティリティ（マップロジック） =====================
-inline s3d::Array<s3d::Point> LineCells(const s3d::Point& a, const s3d::Point& b) {
+// a から b までの Bresenham 直線のセルを順に fn(const Point&) へ渡す（a・b を含む。確保なし）
+// fn が bool を返す場合、false で打ち切る
+template <class Fn>
+inline void ForEachLineCell(const s3d::Point& a, const s3d::Point& b, Fn fn) {
 	using namespace s3d;
-	Array<Point> out;
-	int x0 = a.x, y0 = a.y, x1 = b.x, y1 = b.y;
+	int x0 = a.x, y0 = a.y;
+	const int x1 = b.x, y1 = b.y;
 	const int dx = std::abs(x1 - x0), sx = (x0 < x1 ? 1 : -1);
 	const int dy = -std::abs(y1 - y0), sy = (y0 < y1 ? 1 : -1);
 	int err = dx + dy;
 	while (true) {
-		out << Point{ x0, y0 };
+		if constexpr (std::is_same_v<std::invoke_result_t<Fn&, const Point&>, bool>) {
+			if (!fn(Point{ x0, y0 })) return;
+		}
+		else {
+			fn(Point{ x0, y0 });
+		}
 		if (x0 == x1 && y0 == y1) break;
-		int e2 = 2 * err;
+		const int e2 = 2 * err;
 		if (e2 >= dy) { err += dy; x0 += sx; }
 		if (e2 <= dx) { err += dx; y0 += sy; }
 	}
+}
+
+// ForEachLineCell が渡すセルの数
+inline int LineCellCount(const s3d::Point& a, const s3d::Point& b) noexcept {
+	return (s3d::Max(std::abs(b.x - a.x), std::abs(b.y - a.y)) + 1);
+}
+
+inline s3d::Array<s3d::Point> LineCells(const s3d::Point& a, const s3d::Point& b) {
+	s3d::Array<s3d::Point> out;
+	out.reserve(LineCellCount(a, b));
+	ForEachLineCell(a, b, [&](const s3d::Point& c) { out << c; });
 	return out;
 }
 
 inline s3d::Point RaycastUntilWall(const Board& brd, const s3d::Point& a, const s3d::Point& b) {
-	using namespace s3d;
-	const auto path = LineCells(a, b);
-	Point last = a;
-	for (int i = 0; i < (int)path.size(); ++i) {
-		const Point c = path[i];
-		if (!brd.inBounds(c.x, c.y)) return last;
-		const TileKind k = brd.tiles[brd.idx(c.x, c.y)].kind;
-		if (k == TileKind::Wall) return last;
+	s3d::Point last = a;
+	ForEachLineCell(a, b, [&](const s3d::Point& c) {
+		if (!brd.inBounds(c.x, c.y)) return false;
+		if (brd.kind[brd.idx(c.x, c.y)] == TileKind::Wall) return false;
 		last = c;
-	}
+		return true;
+		});
 	return last;
 }
 
@@ -42,12 +58,8 @@ inline double TileDist(const s3d::Point& a, const s3d::Point& b) {
 	return s3d::Math::Sqrt(dx * dx + dy * dy);
 }
 
+// 支配率（Board が塗りの変更ごとに数えているので O(1)）
 inline std::pair<double, double> Ownership(const Board& brd) {
-	int blue = 0, red = 0;
-	const int total = GW * GH;
-	for (const auto& t : brd.tiles) {
-		if (t.paint > 0.60f) ++blue;
-		else if (t.paint < 0.40f) ++red;
-	}
-	return { (double)blue / total, (double)red / total };
+	const int total = s3d::Max(1, brd.cellCount());
+	return { (double)brd.blueTiles / total, (double)brd.redTiles / total };
 }
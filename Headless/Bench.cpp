@@ -0,0 +1,230 @@
+﻿# include <Siv3D.hpp> // Siv3D v0.6.16
+#include <benchmark/benchmark.h>
+#include "SimCore.h"
+#include "StageFile.h"
+
+// ===================== シミュレーションのマイクロベンチマーク =====================
+// ウィンドウなしで SimCore の重い処理を1つずつ測る（Google Benchmark）。
+//
+//   InkWarsBench [--benchmark_filter=REGEX] [--benchmark_out=FILE]
+//
+// 結果は画面に表として出し、同時に JSON を InkWarsBench.json（--benchmark_out を指定したらそちら）へ書く。
+// リリースごとの JSON を並べて比べれば退行が分かる。
+//
+// 盤面は合成（壁の帯・ランダムな塗り・Red 構造物）で 36x20 / 256x256 / 1024x1024。
+// 盤面の大きさは引数の1つ目（横幅）で選ぶ。
+SIV3D_SET(EngineOption::Renderer::Headless)
+
+using namespace s3d;
+
+// SimCore の private な処理への入り口（SimCore.h で friend にしてある）
+struct SimBench {
+	static Optional<Point> FindTargetCell(SimCore& sim, Team atk, const Point& from, int range, bool turretOnly, bool needsSight) {
+		return sim.findTargetCell(atk, from, range, turretOnly, needsSight);
+	}
+	static void ApplyAOE(SimCore& sim, const Point& center, int r, double paintDelta, double dmg, Team atk) {
+		sim.applyAOE(center, r, paintDelta, dmg, atk);
+	}
+	static void UpdateProjectiles(SimCore& sim, double dt) { sim.updateProjectiles(dt); }
+	static void UpdateRedAgents(SimCore& sim, double dt) { sim.updateRedAgents(dt); }
+	static void SpawnEnemyAt(SimCore& sim, const Point& c) { sim.spawnEnemyAt(c); }
+	static void EnemyPlaceAI(SimCore& sim) { sim.enemyPlaceAI(); }
+};
+
+namespace {
+	// 合成ステージ：横の壁の帯（ところどころ切れ目）・ランダムな塗り・Red 構造物を散らす
+	Array<uint8> MakeSyntheticStage(int32 w, int32 h, uint64 seed) {
+		SmallRNG rng{ seed };
+		Array<String> rows(h, String(w, U'.'));
+		for (int32 y = 0; y < h; ++y) {
+			for (int32 x = 0; x < w; ++x) {
+				const double r = Random(rng);
+				char32& ch = rows[y][x];
+				if (r < 0.30) ch = U'b';
+				else if (r < 0.60) ch = U'r';
+				else if (r < 0.61) ch = U't';
+				else if (r < 0.612) ch = U'm';
+			}
+		}
+		for (int32 y = 6; y < h - 2; y += 8) {
+			for (int32 x = 2; x < w - 2; ++x) {
+				if ((x % 12) != 0) rows[y][x] = U'0';
+			}
+		}
+		rows[1][1] = U'P';
+		rows[h - 2][w - 2] = U'E';
+		return EncodeStageGrid(rows, 1000, 1000);
+	}
+
+	Size BoardSize(int64 w) {
+		return (w == 36 ? Size{ 36, 20 } : Size{ (int32)w, (int32)w });
+	}
+
+	// 盤面の大きさごとに1回だけ作る
+	const SimCore& SyntheticSim(int64 w) {
+		static HashTable<int64, std::unique_ptr<SimCore>> cache;
+		auto& slot = cache[w];
+		if (!slot) {
+			const Size size = BoardSize(w);
+			const Array<uint8> stage = MakeSyntheticStage(size.x, size.y, 0xBE7C4ull + (uint64)w);
+			slot = std::make_unique<SimCore>();
+			slot->eventsEnabled = false;
+			slot->seed = 1;
+			slot->loadStage(stage.data(), stage.size());
+		}
+		return *slot;
+	}
+
+	// 盤面上にランダムな弾を count 発（2割が放物線弾）。寿命は長く、ほぼ飛び続ける
+	void FillProjectiles(SimCore& sim, int64 count, uint64 seed) {
+		SmallRNG rng{ seed };
+		const Board& b = sim.brd;
+		sim.projectiles.clear();
+		sim.projectiles.reserve((size_t)count, (size_t)count / 4 + 1);
+		for (int64 i = 0; i < count; ++i) {
+			const Point from{ Random(0, b.w - 1, rng), Random(0, b.h - 1, rng) };
+			const Point to{ Random(0, b.w - 1, rng), Random(0, b.h - 1, rng) };
+			const Vec2 p0 = b.cellCenter(from), p1 = b.cellCenter(to);
+			const Team atk = ((i & 1) ? Team::Blue : Team::Red);
+			if ((i % 5) == 0) {
+				const Vec2 apex = (p0 + p1) * 0.5 + Vec2{ 0, -120 };
+				sim.projectiles.arcs.push(atk, p0, apex, p1, 0.2, to, 60.0, 1, 5.0, 0.1, 6.0);
+			}
+			else {
+				const Vec2 v = (p1 - p0).normalized() * 200.0;
+				sim.projectiles.straight.push(ProjKind::Bullet, atk, p0, v, to, true, 60.0, 5.0, 0.05, 4.0);
+			}
+		}
+	}
+
+	void SizeArgs(benchmark::internal::Benchmark* b) {
+		for (const int64 w : { 36, 256, 1024 }) b->Arg(w);
+	}
+}
+
+// ---- 支配率 ----
+static void BM_Ownership(benchmark::State& state) {
+	const SimCore& sim = SyntheticSim(state.range(0));
+	for (auto _ : state) benchmark::DoNotOptimize(Ownership(sim.brd));
+}
+BENCHMARK(BM_Ownership)->Apply(SizeArgs);
+
+// ---- ターゲット選択（range(1) = 1: 射線あり） ----
+static void BM_FindTargetCell(benchmark::State& state) {
+	SimCore sim = SyntheticSim(state.range(0));
+	const bool sight = (state.range(1) != 0);
+	// 同じ砲台群から撃ち続ける（射線キャッシュは効く前提）
+	Array<Point> from;
+	SmallRNG rng{ 7 };
+	for (int i = 0; i < 64; ++i) from << Point{ Random(0, sim.brd.w - 1, rng), Random(0, sim.brd.h - 1, rng) };
+	size_t k = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(SimBench::FindTargetCell(sim, Team::Red, from[k], 12, false, sight));
+		k = ((k + 1) & 63);
+	}
+}
+BENCHMARK(BM_FindTargetCell)->ArgsProduct({ { 36, 256, 1024 }, { 0, 1 } });
+
+// ---- 範囲塗り（range(1) = 半径） ----
+static void BM_ApplyAOE(benchmark::State& state) {
+	SimCore sim = SyntheticSim(state.range(0));
+	const int r = (int)state.range(1);
+	SmallRNG rng{ 3 };
+	for (auto _ : state) {
+		const Point c{ Random(0, sim.brd.w - 1, rng), Random(0, sim.brd.h - 1, rng) };
+		SimBench::ApplyAOE(sim, c, r, ((c.x & 1) ? 0.2 : -0.2), 4.0, ((c.x & 1) ? Team::Blue : Team::Red));
+	}
+}
+BENCHMARK(BM_ApplyAOE)->ArgsProduct({ { 36, 256, 1024 }, { 1, 3, 6 } });
+
+// ---- 実弾の更新（256x256、range(0) = 弾数） ----
+static void BM_UpdateProjectiles(benchmark::State& state) {
+	SimCore sim = SyntheticSim(256);
+	FillProjectiles(sim, state.range(0), 11);
+	const ProjectilePool initial = sim.projectiles;
+	for (auto _ : state) {
+		SimBench::UpdateProjectiles(sim, SimFixedDt);
+		state.PauseTiming();
+		sim.projectiles = initial; // 着弾で減ったぶんを戻す
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateProjectiles)->RangeMultiplier(10)->Range(10, 100'000);
+
+// ---- 敵ユニットの更新（256x256、range(0) = ユニット数） ----
+static void BM_UpdateRedAgents(benchmark::State& state) {
+	SimCore sim = SyntheticSim(256);
+	SmallRNG rng{ 5 };
+	for (int64 i = 0; i < state.range(0); ++i) {
+		Point c;
+		do { c = Point{ Random(0, sim.brd.w - 1, rng), Random(0, sim.brd.h - 1, rng) }; } while (sim.brd.kind[sim.brd.idx(c.x, c.y)] == TileKind::Wall);
+		SimBench::SpawnEnemyAt(sim, c);
+	}
+	for (auto& e : sim.redAgents) e.life = 1e9; // 寿命で消えないように
+	SimBench::UpdateRedAgents(sim, SimFixedDt); // 誘導場は最初の1回で作る
+	const Array<Actor> initial = sim.redAgents;
+	for (auto _ : state) {
+		SimBench::UpdateRedAgents(sim, SimFixedDt);
+		state.PauseTiming();
+		sim.redAgents = initial; // 体当たりで消えたぶんを戻す
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateRedAgents)->RangeMultiplier(10)->Range(10, 10'000);
+
+// ---- 直線上のセル（range(0) = 長さ） ----
+static void BM_LineCells(benchmark::State& state) {
+	const int n = (int)state.range(0);
+	for (auto _ : state) benchmark::DoNotOptimize(LineCells(Point{ 0, 0 }, Point{ n, n / 3 }));
+}
+BENCHMARK(BM_LineCells)->RangeMultiplier(8)->Range(8, 1024);
+
+static void BM_ForEachLineCell(benchmark::State& state) {
+	const int n = (int)state.range(0);
+	for (auto _ : state) {
+		int sum = 0;
+		ForEachLineCell(Point{ 0, 0 }, Point{ n, n / 3 }, [&](const Point& c) { sum += c.y; });
+		benchmark::DoNotOptimize(sum);
+	}
+}
+BENCHMARK(BM_ForEachLineCell)->RangeMultiplier(8)->Range(8, 1024);
+
+// ---- 敵の設置AI（range(1) = 0: ランダム / 1: プランナー（候補ごと4回の試行で固定）） ----
+static void BM_EnemyPlaceAI(benchmark::State& state) {
+	SimCore base = SyntheticSim(state.range(0));
+	base.stage = 3;
+	base.redAI.plannerFromStage = (state.range(1) ? 1 : 1'000'000);
+	base.redAI.fixedRollouts = 4;
+	for (auto _ : state) {
+		state.PauseTiming();
+		SimCore sim = base;
+		state.ResumeTiming();
+		SimBench::EnemyPlaceAI(sim);
+		benchmark::DoNotOptimize(sim.moneyRed);
+		state.PauseTiming();
+		sim = SimCore{}; // 解放は測らない
+		state.ResumeTiming();
+	}
+}
+// プランナーは大きな盤面だと1回に数秒かかるので 36x20 だけ
+BENCHMARK(BM_EnemyPlaceAI)->Args({ 36, 0 })->Args({ 256, 0 })->Args({ 1024, 0 })->Args({ 36, 1 })->Unit(benchmark::kMillisecond);
+
+void Main() {
+	// Google Benchmark の引数はそのまま渡す。--benchmark_out がなければ JSON を既定のファイルへ
+	Array<std::string> args;
+	for (const auto& a : System::GetCommandLineArgs()) args << a.toUTF8();
+	if (!args.any([](const std::string& a) { return a.starts_with("--benchmark_out="); })) {
+		args << "--benchmark_out=InkWarsBench.json";
+		args << "--benchmark_out_format=json";
+	}
+
+	Array<char*> argv;
+	for (auto& a : args) argv << a.data();
+	int argc = (int)argv.size();
+
+	benchmark::Initialize(&argc, argv.data());
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+}
@@ -0,0 +1,162 @@
+﻿# include <Siv3D.hpp> // Siv3D v0.6.16
+#include "SimCore.h"
+#include "StageFile.h"
+#include "Replay.h"
+
+// ===================== ヘッドレス・シミュレーション CLI =====================
+// GPU もウィンドウも音声も使わずに SimCore だけでターンを回す（バランス検証・回帰テスト用）
+//
+//   InkWarsSim [--turns N] [--stage S] [--seed X] [--dt SEC] [--planner-from S] [--planner-rollouts N]
+//   InkWarsSim --export-stages DIR                       組み込みステージを DIR/stageN.iwstage に書き出す
+//   InkWarsSim --convert GRID.txt --out OUT.iwstage [--stage S]   文字グリッドを .iwstage に変換（資金は S の既定値）
+//   InkWarsSim --replay FILE.iwreplay                    リプレイを最後まで再生して結果を出す
+//
+//   --turns  実行するターン数（既定 1000）
+//   --stage  開始ステージ（既定 1）
+//   --seed   試合シード（既定 1）。同じシードなら同じ結果になる
+//   --dt     1ステップの秒数（既定 SimFixedDt）
+//   --planner-from      敵の設置プランナーを使い始めるステージ（既定 RedPlannerFromStage）
+//   --planner-rollouts  プランナーの候補ごとの試行回数。指定すると時間で打ち切らない（同じシードなら同じ結果）
+//   --record FILE       実行した試合をリプレイとして保存する（--dt を変えたときは再現できない）
+//   --load FILE         ステージの代わりにセーブデータ（.iwsave）から始める
+//   --save FILE         最後の状態をセーブデータとして保存する
+//
+// 勝敗が付いたら同じステージを作り直して続行する。
+SIV3D_SET(EngineOption::Renderer::Headless)
+
+void Main() {
+	using namespace s3d;
+
+	int32 turns = 1000;
+	int32 stageNo = 1;
+	uint64 seed = 1;
+	double dt = SimFixedDt;
+	RedAISettings redAI;
+	String exportDir, convertIn, convertOut, replayIn, recordOut, loadIn, saveOut;
+
+	const Array<String>& args = System::GetCommandLineArgs();
+	for (size_t i = 1; (i + 1) < args.size(); ++i) {
+		if (args[i] == U"--turns") turns = ParseOr<int32>(args[++i], turns);
+		else if (args[i] == U"--stage") stageNo = ParseOr<int32>(args[++i], stageNo);
+		else if (args[i] == U"--seed") seed = ParseOr<uint64>(args[++i], seed);
+		else if (args[i] == U"--dt") dt = ParseOr<double>(args[++i], dt);
+		else if (args[i] == U"--planner-from") redAI.plannerFromStage = ParseOr<int32>(args[++i], redAI.plannerFromStage);
+		else if (args[i] == U"--planner-rollouts") redAI.fixedRollouts = ParseOr<int32>(args[++i], redAI.fixedRollouts);
+		else if (args[i] == U"--export-stages") exportDir = args[++i];
+		else if (args[i] == U"--convert") convertIn = args[++i];
+		else if (args[i] == U"--out") convertOut = args[++i];
+		else if (args[i] == U"--replay") replayIn = args[++i];
+		else if (args[i] == U"--record") recordOut = args[++i];
+		else if (args[i] == U"--load") loadIn = args[++i];
+		else if (args[i] == U"--save") saveOut = args[++i];
+	}
+
+	// ステージ変換
+	const auto writeStage = [](const FilePath& path, const Array<uint8>& bytes) {
+		BinaryWriter writer{ path };
+		if (!writer) { Console << U"cannot write: {}"_fmt(path); return false; }
+		writer.write(bytes.data(), bytes.size());
+		Console << U"wrote {} ({} bytes)"_fmt(path, bytes.size());
+		return true;
+		};
+	if (!exportDir.isEmpty()) {
+		FileSystem::CreateDirectories(exportDir);
+		for (int32 n = 1; n <= 3; ++n) {
+			writeStage(U"{}/stage{}.iwstage"_fmt(exportDir, n), EncodeBuiltinStage(n));
+		}
+		return;
+	}
+	if (!convertIn.isEmpty()) {
+		const Array<String> rows = LoadStageGridText(convertIn);
+		if (rows.isEmpty()) { Console << U"empty or missing grid: {}"_fmt(convertIn); return; }
+		const Array<uint8> bytes = EncodeStageGrid(rows, DefaultStageMoneyBlue(stageNo), DefaultStageMoneyRed(stageNo));
+		SimCore check;
+		if (!check.loadStage(bytes.data(), bytes.size())) { Console << U"grid needs both HQs ('P' and 'E'): {}"_fmt(convertIn); return; }
+		writeStage((!convertOut.isEmpty() ? convertOut : (FileSystem::BaseName(convertIn) + U".iwstage")), bytes);
+		return;
+	}
+
+	// リプレイ再生
+	if (!replayIn.isEmpty()) {
+		auto data = LoadReplayFile(replayIn);
+		if (!data) { Console << U"cannot read replay: {}"_fmt(replayIn); return; }
+		SimCore sim;
+		sim.eventsEnabled = false;
+		sim.redAI = redAI;
+		ReplayPlayer player{ std::move(*data) };
+		player.restart(sim);
+
+		const Stopwatch sw{ StartImmediately::Yes };
+		while (!player.isFinished() && player.advance(sim, ReplayKeyframeTicks) > 0) {}
+		if (!player.isFinished()) Console << U"replay stalled at tick {} / {}"_fmt(player.tick(), player.endTick());
+
+		const auto [bp, rp] = Ownership(sim.brd);
+		Console << U"replay: {} ticks / {:.3f}s"_fmt(player.tick(), sw.sF());
+		Console << U"seed: {} / stage: {} / turn: {}"_fmt(player.data().seed, sim.stage, sim.turnCount);
+		Console << U"last board: BLUE {:.1f}% / RED {:.1f}% / $ {} : {}"_fmt(bp * 100.0, rp * 100.0, sim.moneyBlue, sim.moneyRed);
+		return;
+	}
+
+	SimCore sim;
+	sim.eventsEnabled = false; // 演出は不要
+	sim.seed = seed;
+	sim.redAI = redAI;
+	if (!loadIn.isEmpty()) {
+		const Stopwatch load{ StartImmediately::Yes };
+		if (!LoadSnapshotFile(loadIn, sim)) { Console << U"cannot read save: {}"_fmt(loadIn); return; }
+		Console << U"loaded {} ({}x{}, {:.0f}us)"_fmt(loadIn, sim.brd.w, sim.brd.h, load.usF());
+		seed = sim.seed;
+		stageNo = sim.stage;
+	}
+	else {
+		sim.buildMapForStage(stageNo);
+	}
+
+	int32 blueWins = 0, blueLosses = 0;
+	int64 steps = 0;
+	ReplayRecorder recorder;
+	recorder.begin(seed, stageNo, (loadIn.isEmpty() ? Array<uint8>{} : WriteSnapshot(sim)));
+
+	const Stopwatch sw{ StartImmediately::Yes };
+
+	for (int32 i = 0; i < turns; ++i) {
+		recorder.record(steps, ReplayOp::BeginSim);
+		sim.beginTurn();
+		while (true) {
+			++steps;
+			if (sim.step(dt)) break;
+		}
+
+		if (sim.isBlueLose()) {
+			++blueLosses;
+			recorder.record(steps, ReplayOp::Retry);
+			sim.buildMapForStage(stageNo);
+		}
+		else if (sim.isBlueWin()) {
+			++blueWins;
+			recorder.record(steps, ReplayOp::Retry);
+			sim.buildMapForStage(stageNo);
+		}
+		else {
+			sim.endTurnAndScore();
+			recorder.record(steps, ReplayOp::EndTurn, 0, Point{ 0, 0 }, sim.plannerRoundsLog);
+		}
+	}
+
+	const double sec = sw.sF();
+	const auto [bp, rp] = Ownership(sim.brd);
+
+	Console << U"turns: {} / steps: {} / {:.3f}s ({:.0f} turns/s)"_fmt(turns, steps, sec, (sec > 0.0 ? turns / sec : 0.0));
+	Console << U"blue win: {} / blue lose: {}"_fmt(blueWins, blueLosses);
+	Console << U"seed: {}"_fmt(seed);
+	Console << U"last board: BLUE {:.1f}% / RED {:.1f}% / $ {} : {}"_fmt(bp * 100.0, rp * 100.0, sim.moneyBlue, sim.moneyRed);
+
+	if (!saveOut.isEmpty()) {
+		if (SaveSnapshotFile(saveOut, sim, Phase::Planning)) Console << U"wrote {}"_fmt(saveOut);
+		else Console << U"cannot write: {}"_fmt(saveOut);
+	}
+	if (!recordOut.isEmpty()) {
+		if (SaveReplayFile(recordOut, recorder.finish(steps))) Console << U"wrote {}"_fmt(recordOut);
+		else Console << U"cannot write: {}"_fmt(recordOut);
+	}
+}
@@ -0,0 +1,259 @@
+﻿# include <Siv3D.hpp> // Siv3D v0.6.16
+#include "SimCore.h"
+#include "RedPlanner.h"
+#include "ThreadPool.h"
+
+// ===================== バランス調整トーナメント =====================
+// ステージを最初から勝敗が付くまで（または --turns ターンまで）ヘッドレスで何試合も回し、
+// バランス値（SimParams）の組み合わせごとの勝率・ターン数・支配率の推移を CSV に書き出す。
+// 試合はすべてのコアで並列に回す（1試合は1スレッド。プランナーの試行もそのスレッドの中で回す）。
+//
+//   InkWarsTournament [--games N] [--stage S] [--seed X] [--turns T] [--blue P] [--red P] [--rollouts N]
+//                     [--threads N] [--sweep KEY=V,V,...]... [--out FILE.csv] [--curves FILE.csv]
+//
+//   --games     組み合わせごとの試合数（既定 200）
+//   --stage     試合するステージ（既定 1）
+//   --seed      最初の試合シード（既定 1）。i 試合目は seed + i で、どの組み合わせも同じシード列を使う
+//   --turns     これだけ回して決着が付かなければ引き分け（既定 60）
+//   --blue      Blue の置き方  idle: 置かない / scripted: 左半分にランダム（既定）/ planner: プランナー
+//   --red       Red の置き方   stage: ゲームと同じ（既定）/ random / planner
+//   --rollouts  プランナーの候補ごとの試行回数（既定 8。時間では打ち切らないので結果は決定的）
+//   --threads   同時に回す試合数（既定 コア数）
+//   --sweep     振る値。KEY は SimParams::set の名前、値はカンマ区切りか LO:HI:STEP
+//               （例 --sweep basic.cost=60:100:20 --sweep mortar.damage=25,35）。複数あれば総当たり
+//   --out       組み合わせごとの集計（既定 tournament.csv）
+//   --curves    組み合わせ・ターンごとの平均支配率（既定 tournament_curves.csv）。決着した試合は最後の値のまま数える
+SIV3D_SET(EngineOption::Renderer::Headless)
+
+using namespace s3d;
+
+namespace {
+	enum class Policy { Idle, Scripted, Planner, Stage };
+	enum class MatchResult : int32 { BlueWin, RedWin, Draw };
+
+	struct TournamentSettings {
+		int32 stage = 1;
+		int32 maxTurns = 60;
+		Policy blue = Policy::Scripted;
+		Policy red = Policy::Stage;
+		int32 rollouts = 8;
+	};
+
+	struct Sweep {
+		String key;
+		Array<double> values;
+	};
+
+	struct MatchStats {
+		MatchResult result = MatchResult::Draw;
+		int32 turns = 0;
+		Array<float> blueShare, redShare; // ターンごと（シミュレーションの終わり）の支配率
+	};
+
+	// "60,80,100" / "60:100:20" / 混在も可
+	Array<double> ParseValues(const String& text) {
+		Array<double> out;
+		for (const String& item : text.split(U',')) {
+			const Array<String> range = item.split(U':');
+			if (range.size() == 3) {
+				const double lo = ParseOr<double>(range[0], 0.0), hi = ParseOr<double>(range[1], 0.0), step = ParseOr<double>(range[2], 0.0);
+				if (step <= 0.0) continue;
+				for (double v = lo; v <= hi + step * 1e-6; v += step) out << v;
+			}
+			else if (const auto v = ParseOpt<double>(item)) {
+				out << *v;
+			}
+		}
+		return out;
+	}
+
+	Optional<Policy> ParsePolicy(const String& s) {
+		if (s == U"idle") return Policy::Idle;
+		if (s == U"scripted" || s == U"random") return Policy::Scripted;
+		if (s == U"planner") return Policy::Planner;
+		if (s == U"stage") return Policy::Stage;
+		return none;
+	}
+
+	// Blue のランダム設置（SimCore::enemyPlaceRandom を左右反転したもの。スポナーはない）
+	void BluePlaceScripted(SimCore& sim, SmallRNG& rng) {
+		const auto affordable = [&](StructureType t) { return (sim.moneyBlue >= sim.params.spec(t).cost); };
+		for (int tries = 18; tries > 0; --tries) {
+			Array<StructureType> bag;
+			if (affordable(StructureType::Basic))     bag << StructureType::Basic;
+			if (affordable(StructureType::Sprinkler)) bag << StructureType::Sprinkler;
+			if (affordable(StructureType::Mortar))    bag << StructureType::Mortar;
+			if (sim.stage >= 2 && affordable(StructureType::Sniper) && RandomBool(0.35, rng)) bag << StructureType::Sniper;
+			if (affordable(StructureType::Pump) && RandomBool(0.25, rng)) bag << StructureType::Pump;
+			if (bag.isEmpty()) break;
+
+			const StructureType pick = bag.choice(rng);
+			const auto spot = sim.sampleAISpot(Team::Blue, rng);
+			if (!spot) break;
+			sim.placeBlue(pick, *spot);
+		}
+	}
+
+	// Blue のプランナー設置（Red の enemyPlacePlanned と同じく1つずつ）
+	void BluePlacePlanned(SimCore& sim, SmallRNG& rng, const RedAISettings& settings) {
+		for (int n = 0; n < RedPlannerMaxPlacements; ++n) {
+			const auto pick = PlanPlacement(sim, Team::Blue, rng, settings, 0.0);
+			if (!pick || !sim.placeBlue(pick->type, pick->cell)) break;
+		}
+	}
+
+	MatchStats PlayMatch(const SimParams& params, const TournamentSettings& ts, uint64 seed) {
+		SimCore sim;
+		sim.eventsEnabled = false;
+		sim.seed = seed;
+		sim.params = params;
+		sim.redAI.fixedRollouts = ts.rollouts;
+		sim.redAI.parallel = false; // 試合ごとに別スレッドなので、中でさらに分けない
+		if (ts.red == Policy::Scripted) sim.redAI.plannerFromStage = INT32_MAX;
+		else if (ts.red == Policy::Planner) sim.redAI.plannerFromStage = 1;
+		sim.buildMapForStage(ts.stage);
+
+		// Blue の判断は盤面の乱数とは別の列で（Blue の置き方を変えても Red 側の乱数がずれないように）
+		SmallRNG blueRng;
+		blueRng.seed(seed ^ 0xB1E5EEDull);
+
+		MatchStats stats;
+		for (int32 turn = 1; turn <= ts.maxTurns; ++turn) {
+			if (ts.blue == Policy::Scripted) BluePlaceScripted(sim, blueRng);
+			else if (ts.blue == Policy::Planner) BluePlacePlanned(sim, blueRng, sim.redAI);
+
+			sim.beginTurn();
+			while (!sim.step(SimFixedDt)) {}
+
+			const auto [bp, rp] = Ownership(sim.brd);
+			stats.blueShare << (float)bp;
+			stats.redShare << (float)rp;
+			stats.turns = turn;
+
+			if (sim.isBlueLose()) { stats.result = MatchResult::RedWin; break; }
+			if (sim.isBlueWin()) { stats.result = MatchResult::BlueWin; break; }
+			sim.endTurnAndScore();
+		}
+		return stats;
+	}
+
+	// 組み合わせ番号 -> 各 Sweep の値（最初の Sweep がいちばん速く変わる）
+	Array<double> ComboValues(const Array<Sweep>& sweeps, size_t combo) {
+		Array<double> values;
+		for (const Sweep& s : sweeps) {
+			values << s.values[combo % s.values.size()];
+			combo /= s.values.size();
+		}
+		return values;
+	}
+}
+
+void Main() {
+	int32 games = 200;
+	uint64 seed = 1;
+	size_t threads = Threading::GetConcurrency();
+	TournamentSettings ts;
+	Array<Sweep> sweeps;
+	FilePath outPath = U"tournament.csv", curvesPath = U"tournament_curves.csv";
+
+	const Array<String>& args = System::GetCommandLineArgs();
+	for (size_t i = 1; (i + 1) < args.size(); ++i) {
+		if (args[i] == U"--games") games = Max(ParseOr<int32>(args[++i], games), 1);
+		else if (args[i] == U"--stage") ts.stage = ParseOr<int32>(args[++i], ts.stage);
+		else if (args[i] == U"--seed") seed = ParseOr<uint64>(args[++i], seed);
+		else if (args[i] == U"--turns") ts.maxTurns = Max(ParseOr<int32>(args[++i], ts.maxTurns), 1);
+		else if (args[i] == U"--rollouts") ts.rollouts = Max(ParseOr<int32>(args[++i], ts.rollouts), 1);
+		else if (args[i] == U"--threads") threads = Max<size_t>(ParseOr<size_t>(args[++i], threads), 1);
+		else if (args[i] == U"--out") outPath = args[++i];
+		else if (args[i] == U"--curves") curvesPath = args[++i];
+		else if (args[i] == U"--blue" || args[i] == U"--red") {
+			const bool blue = (args[i] == U"--blue");
+			const auto policy = ParsePolicy(args[++i]);
+			if (!policy || (blue && *policy == Policy::Stage) || (!blue && *policy == Policy::Idle)) { Console << U"unknown policy: {}"_fmt(args[i]); return; }
+			(blue ? ts.blue : ts.red) = *policy;
+		}
+		else if (args[i] == U"--sweep") {
+			const String& spec = args[++i];
+			const size_t eq = spec.indexOf(U'=');
+			Sweep s;
+			if (eq < spec.size()) s = Sweep{ spec.substr(0, eq), ParseValues(spec.substr(eq + 1)) };
+			if (s.values.isEmpty() || !SimParams{}.set(s.key, s.values.front())) { Console << U"bad sweep: {}"_fmt(spec); return; }
+			sweeps << s;
+		}
+	}
+
+	size_t combos = 1;
+	for (const Sweep& s : sweeps) combos *= s.values.size();
+
+	// 組み合わせ × 試合を1つの列にして、空いたスレッドから順に取る
+	const size_t total = (combos * (size_t)games);
+	Array<MatchStats> results(total);
+	ThreadPool pool{ threads - 1 };
+
+	Console << U"{} combination(s) x {} game(s) on {} thread(s)"_fmt(combos, games, pool.concurrency());
+	const Stopwatch sw{ StartImmediately::Yes };
+
+	const size_t chunk = (pool.concurrency() * 16);
+	for (size_t begin = 0; begin < total; begin += chunk) {
+		const size_t n = Min(chunk, (total - begin));
+		pool.parallelFor(n, [&](size_t k) {
+			const size_t job = (begin + k);
+			const size_t combo = (job / games);
+			SimParams params;
+			const Array<double> values = ComboValues(sweeps, combo);
+			for (size_t j = 0; j < sweeps.size(); ++j) params.set(sweeps[j].key, values[j]);
+			results[job] = PlayMatch(params, ts, (seed + (job % games)));
+			});
+		Console << U"{} / {} games ({:.1f}s)"_fmt(begin + n, total, sw.sF());
+	}
+
+	// 集計
+	TextWriter out{ outPath }, curves{ curvesPath };
+	if (!out || !curves) { Console << U"cannot write: {} / {}"_fmt(outPath, curvesPath); return; }
+
+	String keys;
+	for (const Sweep& s : sweeps) keys += (s.key + U",");
+	out.writeln(U"combo," + keys + U"games,blue_win_rate,red_win_rate,draw_rate,avg_turns,avg_final_blue,avg_final_red");
+	curves.writeln(U"combo," + keys + U"turn,blue,red,playing");
+
+	for (size_t combo = 0; combo < combos; ++combo) {
+		String values, label;
+		const Array<double> comboValues = ComboValues(sweeps, combo);
+		for (size_t j = 0; j < sweeps.size(); ++j) {
+			values += (Format(comboValues[j]) + U",");
+			label += U"{}={} "_fmt(sweeps[j].key, comboValues[j]);
+		}
+
+		std::array<int32, 3> wins{};
+		double turns = 0.0, finalBlue = 0.0, finalRed = 0.0;
+		Array<double> blue(ts.maxTurns, 0.0), red(ts.maxTurns, 0.0), playing(ts.maxTurns, 0.0);
+		for (int32 g = 0; g < games; ++g) {
+			const MatchStats& m = results[combo * games + g];
+			++wins[(size_t)m.result];
+			turns += m.turns;
+			finalBlue += m.blueShare.back();
+			finalRed += m.redShare.back();
+			for (int32 t = 0; t < ts.maxTurns; ++t) {
+				const size_t at = Min<size_t>(t, (m.blueShare.size() - 1));
+				blue[t] += m.blueShare[at];
+				red[t] += m.redShare[at];
+				if (t < m.turns) playing[t] += 1.0;
+			}
+		}
+
+		const double inv = (1.0 / games);
+		out.writeln(U"{},{}{},{:.4f},{:.4f},{:.4f},{:.2f},{:.4f},{:.4f}"_fmt(combo, values, games,
+			wins[(size_t)MatchResult::BlueWin] * inv, wins[(size_t)MatchResult::RedWin] * inv, wins[(size_t)MatchResult::Draw] * inv,
+			turns * inv, finalBlue * inv, finalRed * inv));
+		for (int32 t = 0; t < ts.maxTurns; ++t) {
+			curves.writeln(U"{},{}{},{:.4f},{:.4f},{:.4f}"_fmt(combo, values, (t + 1), blue[t] * inv, red[t] * inv, playing[t] * inv));
+		}
+
+		Console << U"[{}] {}| blue {:.1f}% / red {:.1f}% / draw {:.1f}% / {:.1f} turns"_fmt(combo, label,
+			wins[(size_t)MatchResult::BlueWin] * inv * 100.0, wins[(size_t)MatchResult::RedWin] * inv * 100.0, wins[(size_t)MatchResult::Draw] * inv * 100.0, turns * inv);
+	}
+
+	const double sec = sw.sF();
+	Console << U"{} games / {:.1f}s ({:.1f} games/s)"_fmt(total, sec, (sec > 0.0 ? total / sec : 0.0));
+	Console << U"wrote {} / {}"_fmt(outPath, curvesPath);
+}
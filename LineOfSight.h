@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Board.h"
+#include "GridUtils.h"
+
+// ===================== 射線（見通し）キャッシュ =====================
+// 砲台のセルと射程ごとに「射程内で、そこまでの直線（Bresenham）に壁がないセル」をビット列で持つ。
+// 壁で止まる弾（TypeSpec::blockedByWalls）の砲台は、これでどうやっても届かないセルを候補から外す。
+// 直線は弾の実際の軌道の近似なので、境目のセルは外れることも当たることもある。
+// 壁が変わったら（Board::wallVersion）全部捨てる。
+struct SightMask {
+	int y0 = 0, y1 = -1;	// 持っている行（盤面座標）
+	int rowWords = 0;		// 1行の語数（盤面の幅ぶん。CellBits と同じ並び）
+	s3d::Array<uint64> words;
+
+	// 盤面の行 y・語 j（範囲外の行は 0）
+	uint64 word(int y, int j) const noexcept {
+		if (y < y0 || y1 < y) return 0;
+		return words[(size_t)(y - y0) * rowWords + j];
+	}
+	bool test(int x, int y) const noexcept {
+		return ((word(y, x >> 6) >> (x & 63)) & 1);
+	}
+};
+
+class LineOfSightCache {
+public:
+	const SightMask& get(const Board& brd, const s3d::Point& from, int range) {
+		if (m_wallVersion != brd.wallVersion) {
+			m_masks.clear();
+			m_wallVersion = brd.wallVersion;
+		}
+		const uint64 key = ((uint64)(uint32)range << 48) | ((uint64)(uint32)from.y << 24) | (uint32)from.x;
+		if (const auto it = m_masks.find(key); it != m_masks.end()) return it->second;
+		return m_masks.emplace(key, build(brd, from, range)).first->second;
+	}
+
+	size_t size() const noexcept { return m_masks.size(); }
+
+private:
+	s3d::HashTable<uint64, SightMask> m_masks;
+	uint32 m_wallVersion = 0;
+
+	static SightMask build(const Board& brd, const s3d::Point& from, int range) {
+		SightMask m;
+		m.y0 = s3d::Max(0, from.y - range);
+		m.y1 = s3d::Min(brd.h - 1, from.y + range);
+		m.rowWords = ((brd.w + 63) / 64);
+		m.words.assign((size_t)(m.y1 - m.y0 + 1) * m.rowWords, 0);
+
+		const int r2 = range * range;
+		for (int y = m.y0; y <= m.y1; ++y) {
+			const int dy = (y - from.y);
+			for (int x = s3d::Max(0, from.x - range); x <= s3d::Min(brd.w - 1, from.x + range); ++x) {
+				const int dx = (x - from.x);
+				if (dx * dx + dy * dy > r2) continue;
+				bool clear = true;
+				ForEachLineCell(from, s3d::Point{ x, y }, [&](const s3d::Point& c) {
+					if (c == from) return true;
+					clear = (brd.kind[brd.idx(c.x, c.y)] != TileKind::Wall);
+					return clear;
+					});
+				if (clear) m.words[(size_t)(y - m.y0) * m.rowWords + (x >> 6)] |= (uint64{ 1 } << (x & 63));
+			}
+		}
+		return m;
+	}
+};
@@ -1,28 +1,9 @@
 ﻿# include <Siv3D.hpp> // Siv3D v0.6.16
 #include "Game.h"
+#include "BgmPlayer.h"
 
 enum class AppState { Title, Playing };
 
-// Rom/ または rom/ 配下から音を探してロード
-static s3d::Audio LoadAudioFromRom(const s3d::FilePath& relUnderRom) {
-	using namespace s3d;
-	const Array<FilePath> candidates = {
-		U"Rom/" + relUnderRom,
-		U"rom/" + relUnderRom,
-		U"../Rom/" + relUnderRom,
-		U"../rom/" + relUnderRom,
-		U"../../Rom/" + relUnderRom,
-		U"../../rom/" + relUnderRom,
-	};
-	for (const auto& p : candidates) {
-		if (FileSystem::Exists(p)) {
-			Audio a{ p };
-			if (a) return a;
-		}
-	}
-	return {};
-}
-
 void Main() {
 	using namespace s3d;
 
@@ -31,31 +12,30 @@ void Main() {
 	FontAsset::Register(U"UI", FontMethod::MSDF, 20, Typeface::Bold);
 	const ScopedRenderStates2D _sampler{ SamplerState::ClampLinear };
 
-	// タイトル/ゲームBGMとUIボタン音
-	Audio bgmTitle = LoadAudioFromRom(U"audio/Title_BGM.mp3");
-	Audio bgmGame = LoadAudioFromRom(U"audio/GameBGM.mp3");
-	Audio uiButton = LoadAudioFromRom(U"audio/Buttom.mp3"); // ファイル名はButtom.mp3想定
+	// テクスチャ・音声はここで登録だけして、読み込みはタイトル画面の裏で進める
+	Game G;
+	G.registerAssets();
 
-	// ループ設定
-	if (bgmTitle) bgmTitle.setLoop(true);
-	if (bgmGame)  bgmGame.setLoop(true);
+	// UIボタン音（読み終わるまでは鳴らない）
+	const Audio& uiButton = G.assets.get(G.assets.sound(U"audio/Buttom.mp3")); // ファイル名はButtom.mp3想定
+
+	// タイトル/ゲームBGM（ストリーミング再生。鳴らすときに開く）
+	BgmPlayer bgm;
 
-	Game G;
 	AppState state = AppState::Title;
 	bool gameInitialized = false;
 
 	while (System::Update()) {
+		Profiler::Get().beginFrame();
 		const double dtReal = Scene::DeltaTime();
 
+		// 読み終わったテクスチャ・音声を取り込む
+		G.assets.update();
+
 		// タイトル画面
 		if (state == AppState::Title) {
 			// タイトルBGM再生（未再生なら）
-			if (bgmTitle && !bgmTitle.isPlaying()) {
-				bgmGame.stop();
-				bgmTitle.setLoop(true);
-				bgmTitle.setVolume(0.3);   // 任意（既定1.0）
-				bgmTitle.play();           // 引数なしで再生
-			}
+			bgm.play(U"audio/Title_BGM.mp3", 0.3);
 
 			// 背景とタイトル
 			const RectF panel{ 0, 0, (double)Scene::Width(), (double)Scene::Height() };
@@ -75,24 +55,13 @@ void Main() {
 				if (uiButton) uiButton.playOneShot(0.8);
 				if (!gameInitialized) {
 					G.layout();
-					G.buildMapForStage(1);
+					G.startMatch(RandomUint64());
 					gameInitialized = true;
 				}
 				state = AppState::Playing;
 
-				// ゲームBGMへ切替
-				if (bgmTitle) {
-					bgmTitle.stop();
-				}
-				if (bgmGame && !bgmGame.isPlaying()) {
-					bgmGame.setLoop(true);
-					bgmGame.setVolume(0.3);    // 任意（既定1.0）
-					bgmGame.play();            // 引数なしで再生
-					// フェードインしたい場合は以下のように:
-					// bgmGame.setVolume(0.0);
-					// bgmGame.play();
-					// bgmGame.fadeVolume(1.0, 0.6s); // 0.6秒で音量1.0へ
-				}
+				// ゲームBGMへ切替（タイトルBGMは閉じる）
+				bgm.play(U"audio/GameBGM.mp3", 0.3);
 			}
 			if (quit || KeyEscape.down()) {
 				if (uiButton) uiButton.playOneShot(0.8);
@@ -105,17 +74,40 @@ void Main() {
 		G.layout();
 		G.updateEffectsEveryFrame(dtReal);
 
-		if (G.phase == Phase::Planning) {
+		// プロファイラ：[F3] 表示切り替え / [F4] Chrome トレースを profiles/trace.json に保存
+		if (KeyF3.down()) G.showProfiler = !G.showProfiler;
+		if (KeyF4.down()) G.saveProfilerTrace();
+
+		// セーブ：[F7] 今の状態を保存 / [F8] 保存した状態に戻す
+		if (!G.replay) {
+			if (KeyF7.down()) G.quickSave();
+			if (KeyF8.down()) G.quickLoad();
+		}
+
+		// リプレイ：[F5] ここまでの試合を保存 / [F6] 保存したリプレイを再生（もう一度 [F6] で試合に戻る）
+		if (KeyF5.down() && !G.replay) G.saveReplay();
+		if (KeyF6.down()) {
+			if (G.replay) G.stopReplay();
+			else G.startReplay();
+		}
+
+		if (G.replay) {
+			G.updateReplay(dtReal);
+		}
+		else if (G.phase == Phase::Planning) {
 			G.updatePlanning();
 		}
 		else if (G.phase == Phase::Simulating) {
 			G.updateSimulation(dtReal);
-			// 自動フェーズのスキップ（サマリー突入時に演出停止）
-			if (SimpleGUI::Button(U"スキップ", Vec2{ Scene::Width() - UIWidth + 24, Scene::Height() - 48 }, 120)) {
+			// 倍速切り替え（[F] でも可）
+			if (SimpleGUI::Button(U"速度 {}"_fmt(G.simSpeedLabel()), Vec2{ Scene::Width() - UIWidth + 152, Scene::Height() - 48 }, 120, (G.phase == Phase::Simulating))) {
+				if (uiButton) uiButton.playOneShot(0.8);
+				G.cycleSimSpeed();
+			}
+			// 自動フェーズのスキップ（残りを最大速度で最後まで回してからサマリーへ）
+			if (SimpleGUI::Button(U"スキップ", Vec2{ Scene::Width() - UIWidth + 24, Scene::Height() - 48 }, 120, (G.phase == Phase::Simulating && !G.skipping))) {
 				if (uiButton) uiButton.playOneShot(0.8);
-				G.phase = Phase::Summary;
-				G.stageCleared = G.isBlueWin() && !G.isBlueLose();
-				G.clearShakeAndHitStop();
+				G.skipTurn();
 			}
 		}
 		else {
@@ -123,8 +115,9 @@ void Main() {
 		}
 
 		// 盤面描画（シェイク適用）
+		G.updateBoardLayers();
 		{
-			const Transformer2D _tr(Mat3x2::Translate(G.GetShakeOffset()), TransformCursor::No);
+			const Transformer2D _tr(G.boardTransform(G.GetShakeOffset()), TransformCursor::No);
 			G.drawBoard();
 			G.drawStructures();
 			G.drawTracers();
@@ -137,10 +130,12 @@ void Main() {
 		G.drawUI();
 		G.drawHoverHelp();
 		G.drawStageBanner();
+		G.updateProfilerCounters();
+		G.drawProfiler();
 
-		auto [bp, rp] = Ownership(G.brd);
-		const bool blueLose = G.isBlueLose();
-		const bool blueWin = G.isBlueWin();
+		auto [bp, rp] = Ownership(G.sim.brd);
+		const bool blueLose = G.sim.isBlueLose();
+		const bool blueWin = G.sim.isBlueWin();
 		if (blueLose || blueWin) {
 			const String msg = blueLose ? U"敗北条件達成" : U"勝利条件達成";
 			FontAsset(U"UI")(msg).drawAt(28, Vec2{ Scene::Width() * 0.5, 26 }, ColorF{ 1, 1, 0.8 });
@@ -0,0 +1,129 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include <cmath>
+#include "Entities.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define INKWARS_PAINT_SSE2 1
+#endif
+
+// ===================== 塗りの一括加算（AoE の1行ぶん） =====================
+// paint[0..n) に Round(step * scale[k]) 段を足して 0..PaintMax に収める（n <= 32。盤面のチャンク1行は 16 タイル）。
+// step は 0..1 単位の増減量に PaintMax を掛けたもの。
+// 戻り値の bit k が立っているタイルだけ、呼び出し側で支配数・ターゲット索引・設置可能セルを直せばよい。
+//   changed … 値が変わった
+//   crossed … しきい値（支配 PaintRedOwned / PaintBlueOwned、敵色・設置 PaintRedish / PaintBlueish）のどれかをまたいだ
+// before には足す前の値が入る。SSE2 では 8 タイルずつ 32bit に広げて足し、0x8000 ずらした符号付き 16bit への
+// 飽和パックで下限を、16bit の min で上限を取る。4..7 枚の端数も 0 で埋めた 8 枚として同じ処理に通す
+// （AoE の行は短いので、端数を 1 枚ずつ分岐して処理すると全体より遅くなる）。3 枚以下は 1 枚ずつ。
+// 丸めはどちらも最近接偶数（MXCSR の既定）なので、SSE2 がなくても結果は同じ。
+struct PaintRunResult {
+	uint32 changed = 0;
+	uint32 crossed = 0;
+};
+
+namespace detail {
+	// しきい値のどちら側にいるか（4bit）
+	inline uint32 PaintBand(PaintValue p) noexcept {
+		return ((p < PaintRedOwned ? 1u : 0u) | (p < PaintRedish ? 2u : 0u) | (p > PaintBlueish ? 4u : 0u) | (p > PaintBlueOwned ? 8u : 0u));
+	}
+
+	// 最近接偶数への丸め（SIMD 側の _mm_cvtps_epi32 と同じ）
+	inline int32 RoundToInt(float v) noexcept {
+#if INKWARS_PAINT_SSE2
+		return _mm_cvtss_si32(_mm_set_ss(v));
+#else
+		return (int32)std::lrintf(v);
+#endif
+	}
+
+#if INKWARS_PAINT_SSE2
+	// 8 タイルぶんの塗りを 16bit x 8 で読み書きする
+	inline __m128i LoadPaint8(const PaintValue* p) noexcept {
+#	if (INKWARS_PAINT_BITS == 16)
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+#	else
+		return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128());
+#	endif
+	}
+	inline void StorePaint8(PaintValue* p, __m128i v) noexcept {
+#	if (INKWARS_PAINT_BITS == 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+#	else
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(v, _mm_setzero_si128()));
+#	endif
+	}
+	// 16bit x 8 の比較結果 -> 8bit のマスク
+	inline uint32 LaneMask8(__m128i m) noexcept {
+		return (uint32)_mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128()));
+	}
+
+	// 8 タイルぶん（戻り値は bit 0..7）
+	inline PaintRunResult ClampAddPaint8(PaintValue* paint, const float* scale, __m128 step, PaintValue* before) noexcept {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+		const __m128i hiB = _mm_set1_epi16((short)(PaintMax - 0x8000));
+		const __m128i t40 = _mm_set1_epi16((short)(PaintRedOwned - 0x8000)), t45 = _mm_set1_epi16((short)(PaintRedish - 0x8000));
+		const __m128i t55 = _mm_set1_epi16((short)(PaintBlueish - 0x8000)), t60 = _mm_set1_epi16((short)(PaintBlueOwned - 0x8000));
+
+		const __m128i p = LoadPaint8(paint);
+		const __m128i dlo = _mm_cvtps_epi32(_mm_mul_ps(step, _mm_loadu_ps(scale)));
+		const __m128i dhi = _mm_cvtps_epi32(_mm_mul_ps(step, _mm_loadu_ps(scale + 4)));
+		const __m128i sumLo = _mm_sub_epi32(_mm_add_epi32(_mm_unpacklo_epi16(p, zero), dlo), bias32);
+		const __m128i sumHi = _mm_sub_epi32(_mm_add_epi32(_mm_unpackhi_epi16(p, zero), dhi), bias32);
+		// ずらした値（0 -> -0x8000）のまま比べる
+		const __m128i pb = _mm_xor_si128(p, bias16);
+		const __m128i vb = _mm_min_epi16(_mm_packs_epi32(sumLo, sumHi), hiB);
+
+		StorePaint8(before, p);
+		StorePaint8(paint, _mm_xor_si128(vb, bias16));
+
+		PaintRunResult r;
+		r.changed = (~LaneMask8(_mm_cmpeq_epi16(pb, vb)) & 0xFFu);
+		const __m128i c40 = _mm_xor_si128(_mm_cmplt_epi16(pb, t40), _mm_cmplt_epi16(vb, t40));
+		const __m128i c45 = _mm_xor_si128(_mm_cmplt_epi16(pb, t45), _mm_cmplt_epi16(vb, t45));
+		const __m128i c55 = _mm_xor_si128(_mm_cmpgt_epi16(pb, t55), _mm_cmpgt_epi16(vb, t55));
+		const __m128i c60 = _mm_xor_si128(_mm_cmpgt_epi16(pb, t60), _mm_cmpgt_epi16(vb, t60));
+		r.crossed = LaneMask8(_mm_or_si128(_mm_or_si128(c40, c45), _mm_or_si128(c55, c60)));
+		return r;
+	}
+#endif
+}
+
+inline PaintRunResult ClampAddPaintRun(PaintValue* paint, const float* scale, float step, int n, PaintValue* before) noexcept {
+	PaintRunResult r;
+	int k = 0;
+
+#if INKWARS_PAINT_SSE2
+	const __m128 s = _mm_set1_ps(step);
+	for (; (k + 8) <= n; k += 8) {
+		const PaintRunResult t = detail::ClampAddPaint8(paint + k, scale + k, s, before + k);
+		r.changed |= (t.changed << k);
+		r.crossed |= (t.crossed << k);
+	}
+	if ((n - k) >= 4) {
+		// 端数：係数 0 で埋めた 8 枚として通す（埋めたぶんは変わらないのでマスクにも立たない）
+		const int m = (n - k);
+		PaintValue p8[8] = {}, b8[8];
+		float s8[8] = {};
+		for (int j = 0; j < m; ++j) { p8[j] = paint[k + j]; s8[j] = scale[k + j]; }
+		const PaintRunResult t = detail::ClampAddPaint8(p8, s8, s, b8);
+		for (int j = 0; j < m; ++j) { paint[k + j] = p8[j]; before[k + j] = b8[j]; }
+		r.changed |= (t.changed << k);
+		r.crossed |= (t.crossed << k);
+		k = n;
+	}
+#endif
+
+	for (; k < n; ++k) {
+		const PaintValue p = paint[k];
+		const PaintValue v = PaintAdd(p, detail::RoundToInt(step * scale[k]));
+		before[k] = p;
+		paint[k] = v;
+		if (v != p) r.changed |= (1u << k);
+		if (detail::PaintBand(p) != detail::PaintBand(v)) r.crossed |= (1u << k);
+	}
+	return r;
+}
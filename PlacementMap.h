@@ -0,0 +1,136 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include <bit>
+#include "Board.h"
+#include "TargetIndex.h"
+
+// ===================== 設置できるセル =====================
+// チームごとに「床・構造物なし・自軍インクの上」のセルを持つ（SimCore::canPlace のお金以外の条件）。
+//   bits … 盤面全体のビット列（UI の重ね描き用）
+//   list … 該当セルの密な配列（y * w + x）。一様に1つ選ぶのが O(1)
+// お金の条件は種類ごとのコストとの比較だけなので、ここでは持たない（SimCore::isPlaceable）。
+// 塗り・構造物・地形がセル単位で変わるたびに update() で1セルずつ直す。
+class PlacementMap {
+public:
+	void rebuild(const Board& brd) {
+		for (auto& s : m_sets) {
+			s.bits.reset(brd.w, brd.h);
+			s.list.clear();
+			s.slot.assign((size_t)brd.w * brd.h, -1);
+		}
+		brd.forEachCell([&](int x, int y, int) { update(brd, s3d::Point{ x, y }); });
+	}
+
+	// セル c の塗り・構造物・地形が変わった
+	void update(const Board& brd, const s3d::Point& c) {
+		set(m_sets[0], c, allows(brd, c, 0));
+		set(m_sets[1], c, allows(brd, c, 1));
+	}
+
+	// 並び（抽選の結果に効く）ごと作り直す（スナップショットの復元用。盤面を全部見る rebuild より速い）
+	// 置けないセル・重複が混じっていれば false（そのときは rebuild すること）。載っていないセルまでは確かめない
+	bool restore(const Board& brd, const int32* blue, size_t nBlue, const int32* red, size_t nRed) {
+		const size_t n = ((size_t)brd.w * brd.h);
+		for (int k = 0; k < 2; ++k) {
+			Set& s = m_sets[k];
+			s.bits.reset(brd.w, brd.h);
+			s.list.clear();
+			s.slot.assign(n, -1);
+
+			const int32* cells = (k == 0 ? blue : red);
+			const size_t count = (k == 0 ? nBlue : nRed);
+			for (size_t j = 0; j < count; ++j) {
+				const int32 v = cells[j];
+				if (v < 0 || (size_t)v >= n || s.slot[v] >= 0) return false;
+				const s3d::Point c{ v % brd.w, v / brd.w };
+				if (!allows(brd, c, k)) return false;
+				set(s, c, true);
+			}
+		}
+		return true;
+	}
+	// 該当セルの並び（y * w + x）
+	const s3d::Array<int32>& cells(Team side) const noexcept { return of(side).list; }
+
+	bool test(Team side, const s3d::Point& c) const {
+		return of(side).bits.test(c.x, c.y);
+	}
+	size_t count(Team side) const noexcept { return of(side).list.size(); }
+
+	// 該当セルを全部（順不同）
+	template <class Fn>
+	void forEach(Team side, Fn fn) const {
+		const Set& s = of(side);
+		for (const int32 v : s.list) fn(s3d::Point{ v % s.bits.w, v / s.bits.w });
+	}
+
+	// 該当セルのうち region（盤面の外は切る）に入るものを一様に1つ。
+	// まず list から数回ランダムに引き、外れ続けたら region の行のビット列を 64 セルずつ数えて選ぶ
+	// （region が小さくても list 全体は見ない）
+	s3d::Optional<s3d::Point> sample(Team side, s3d::SmallRNG& rng, const s3d::Rect& region) const {
+		const Set& s = of(side);
+		if (s.list.isEmpty()) return s3d::none;
+		const int x0 = s3d::Max(region.x, 0), x1 = s3d::Min(region.x + region.w - 1, s.bits.w - 1);
+		const int y0 = s3d::Max(region.y, 0), y1 = s3d::Min(region.y + region.h - 1, s.bits.h - 1);
+		if (x0 > x1 || y0 > y1) return s3d::none;
+
+		for (int tries = 0; tries < 16; ++tries) {
+			const int32 v = s.list[s3d::Random(size_t{ 0 }, s.list.size() - 1, rng)];
+			const s3d::Point c{ v % s.bits.w, v / s.bits.w };
+			if (x0 <= c.x && c.x <= x1 && y0 <= c.y && c.y <= y1) return c;
+		}
+
+		const int j0 = (x0 >> 6), j1 = (x1 >> 6);
+		size_t n = 0;
+		for (int y = y0; y <= y1; ++y) {
+			for (int j = j0; j <= j1; ++j) n += std::popcount(s.bits.span(y, j, x0, x1));
+		}
+		if (n == 0) return s3d::none;
+		size_t pick = s3d::Random(size_t{ 0 }, n - 1, rng);
+		for (int y = y0; y <= y1; ++y) {
+			for (int j = j0; j <= j1; ++j) {
+				uint64 m = s.bits.span(y, j, x0, x1);
+				const size_t c = (size_t)std::popcount(m);
+				if (pick >= c) { pick -= c; continue; }
+				for (; pick > 0; --pick) m &= (m - 1);
+				return s3d::Point{ j * 64 + std::countr_zero(m), y };
+			}
+		}
+		return s3d::none;
+	}
+
+private:
+	struct Set {
+		CellBits bits;
+		s3d::Array<int32> list;	// y * w + x
+		s3d::Array<int32> slot;	// list の中の位置（-1 = なし）
+	};
+	Set m_sets[2]; // Blue / Red
+
+	const Set& of(Team side) const noexcept { return m_sets[side == Team::Blue ? 0 : 1]; }
+
+	// set 0 = Blue / 1 = Red が c に置けるか
+	static bool allows(const Board& brd, const s3d::Point& c, int set) {
+		const int i = brd.idx(c.x, c.y);
+		const bool free = (brd.kind[i] == TileKind::Floor && !brd.blueIndex[i] && !brd.redIndex[i]);
+		return (free && (set == 0 ? (brd.paint[i] > PaintBlueish) : (brd.paint[i] < PaintRedish)));
+	}
+
+	static void set(Set& s, const s3d::Point& c, bool on) {
+		const int32 v = (c.y * s.bits.w + c.x);
+		int32& slot = s.slot[v];
+		if (on == (slot >= 0)) return;
+		s.bits.set(c.x, c.y, on);
+		if (on) {
+			slot = (int32)s.list.size();
+			s.list << v;
+		}
+		else {
+			const int32 last = s.list.back();
+			s.list[slot] = last;
+			s.slot[last] = slot;
+			s.list.pop_back();
+			slot = -1;
+		}
+	}
+};
@@ -0,0 +1,61 @@
+﻿#include "Profiler.h"
+#include <cstdlib>
+#include <new>
+
+using namespace s3d;
+
+// ===================== 確保回数 =====================
+// 既定の operator new を置き換えて数えるだけ（確保そのものは malloc）。
+// new[] / nothrow 版は既定でこれを呼ぶので、まとめて数えられる。整列指定付きの new は数えない。
+void* operator new(std::size_t size) {
+	ProfilerAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+// ===================== Chrome トレース =====================
+bool SaveChromeTrace(FilePathView path) {
+	TextWriter writer{ path };
+	if (!writer) return false;
+
+	const Profiler& prof = Profiler::Get();
+	writer.writeln(U"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	bool first = true;
+	const auto emit = [&](const String& line) {
+		writer.write(first ? U"" : U",\n");
+		writer.write(line);
+		first = false;
+		};
+
+	emit(U"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}");
+
+	// フレームの区切りと、フレームごとの数
+	prof.frames().each([&](const ProfFrame& f) {
+		const String ts = U"{:.3f}"_fmt(f.startNs / 1000.0);
+		emit(U"{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" + ts + U",\"dur\":" + U"{:.3f}"_fmt(f.frameMs * 1000.0) + U"}");
+
+		String args;
+		for (size_t c = 0; c < (size_t)ProfCounter::Count; ++c) {
+			args += U"\"" + String{ ProfCounterNames[c] } + U"\":" + Format(f.counters[c]) + U",";
+		}
+		args += U"\"allocations\":" + Format(f.allocations);
+		emit(U"{\"name\":\"counts\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":" + ts + U",\"args\":{" + args + U"}}");
+		});
+
+	prof.events().each([&](const ProfEvent& e) {
+		emit(U"{\"name\":\"" + String{ ProfZoneInfos[(size_t)e.zone].name } + U"\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+			+ U"{:.3f}"_fmt(e.startNs / 1000.0) + U",\"dur\":" + U"{:.3f}"_fmt(e.durationNs / 1000.0) + U"}");
+		});
+
+	writer.writeln(U"\n]}");
+	return true;
+}
@@ -0,0 +1,191 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include "Config.h"
+#include "FxRing.h"
+
+// ===================== フレームプロファイラ =====================
+// 名前付きの区間の時間をフレームごとに集計し、直近 ProfilerFrames フレームぶんを持つ。
+//   PROFILE_ZONE(ProfZone::DrawBoard); … そのスコープを抜けるまでを測る
+//   Profiler::Get().beginFrame() をメインループの先頭で毎フレーム呼ぶ（呼んだスレッドだけを測る）
+// プランナーのワーカーから呼ばれた区間や、beginFrame を呼ばないヘッドレス実行では何も記録しない。
+// 区間ごとの記録（Chrome トレース用）も直近 ProfilerMaxEvents 個まで持つ。
+// 区間の時間は入れ子を含む（SimStep は UpdateProjectiles などを含む）。
+
+enum class ProfZone : uint8 {
+	UpdatePlanning,
+	UpdateSimulation,
+	SimStep,
+	Turrets,
+	UpdateProjectiles,
+	UpdateRedAgents,
+	UpdatePlayer,
+	EnemyPlaceAI,
+	ConsumeEvents,
+	UpdateVisuals,
+	UpdateBoardLayers,
+	DrawBoard,
+	DrawStructures,
+	DrawTracers,
+	DrawParticles,
+	DrawProjectiles,
+	DrawActors,
+	DrawUI,
+	Count
+};
+
+// 名前と、表示の字下げ（どの区間の中で呼ばれるか）
+struct ProfZoneInfo {
+	const char32* name;
+	int32 depth;
+};
+inline constexpr std::array<ProfZoneInfo, (size_t)ProfZone::Count> ProfZoneInfos{ {
+	{ U"UpdatePlanning", 0 },
+	{ U"UpdateSimulation", 0 },
+	{ U"SimStep", 1 },
+	{ U"Turrets", 2 },
+	{ U"UpdateProjectiles", 2 },
+	{ U"UpdateRedAgents", 2 },
+	{ U"UpdatePlayer", 2 },
+	{ U"EnemyPlaceAI", 0 },
+	{ U"ConsumeEvents", 0 },
+	{ U"UpdateVisuals", 0 },
+	{ U"UpdateBoardLayers", 0 },
+	{ U"DrawBoard", 0 },
+	{ U"DrawStructures", 0 },
+	{ U"DrawTracers", 0 },
+	{ U"DrawParticles", 0 },
+	{ U"DrawProjectiles", 0 },
+	{ U"DrawActors", 0 },
+	{ U"DrawUI", 0 },
+} };
+
+// フレームごとの数（毎フレーム setCounter で入れる）
+enum class ProfCounter : uint8 { Structures, Projectiles, RedAgents, Particles, Tracers, Count };
+inline constexpr std::array<const char32*, (size_t)ProfCounter::Count> ProfCounterNames{
+	U"structures", U"projectiles", U"agents", U"particles", U"tracers",
+};
+
+// 確保回数（全スレッドの operator new の累計。数えるのは Profiler.cpp。リンクしなければ 0 のまま）
+inline std::atomic<uint64> ProfilerAllocations{ 0 };
+
+struct ProfFrame {
+	int64 startNs = 0;		// プロファイラ開始からの時刻
+	double frameMs = 0.0;	// 次のフレームの開始までの時間
+	std::array<double, (size_t)ProfZone::Count> zoneMs{};
+	std::array<uint32, (size_t)ProfZone::Count> calls{};
+	std::array<int64, (size_t)ProfCounter::Count> counters{};
+	uint64 allocations = 0;
+};
+
+// 区間1回ぶん（Chrome トレースの "X" イベント）
+struct ProfEvent {
+	int64 startNs = 0;
+	int64 durationNs = 0;
+	ProfZone zone = ProfZone::UpdatePlanning;
+};
+
+class Profiler {
+public:
+	static Profiler& Get() {
+		static Profiler instance;
+		return instance;
+	}
+
+	// false の間は区間を測らない（区間1つあたり分岐1回だけ）
+	bool enabled = true;
+
+	// 前のフレームを締めてリングバッファに積み、新しいフレームを始める
+	void beginFrame() {
+		s_threadMeasured = true;
+		const int64 now = nowNs();
+		const uint64 allocs = ProfilerAllocations.load(std::memory_order_relaxed);
+		if (m_started) {
+			m_current.frameMs = ((now - m_current.startNs) * 1e-6);
+			m_current.allocations = (allocs - m_frameAllocs);
+			m_frames.push(m_current);
+		}
+		m_current = ProfFrame{};
+		m_current.startNs = now;
+		m_frameAllocs = allocs;
+		m_started = true;
+	}
+
+	void setCounter(ProfCounter c, int64 value) noexcept { m_current.counters[(size_t)c] = value; }
+
+	// 区間の記録（ProfileScope から呼ぶ）
+	// 測らないスレッド（ヘッドレス・ワーカー）では thread_local を1回読むだけで抜ける
+	static bool Measuring() noexcept { return (s_threadMeasured && Get().enabled); }
+	void record(ProfZone zone, int64 startNs, int64 endNs) {
+		m_current.zoneMs[(size_t)zone] += ((endNs - startNs) * 1e-6);
+		++m_current.calls[(size_t)zone];
+		m_events.push(ProfEvent{ startNs, (endNs - startNs), zone });
+	}
+
+	// 直近 n フレーム（古い順）
+	template <class Fn>
+	void eachFrame(size_t n, Fn fn) const {
+		const size_t skip = (m_frames.size() > n ? (m_frames.size() - n) : 0);
+		size_t k = 0;
+		m_frames.each([&](const ProfFrame& f) { if (k++ >= skip) fn(f); });
+	}
+	size_t frameCount() const noexcept { return m_frames.size(); }
+	const FxRing<ProfFrame>& frames() const noexcept { return m_frames; }
+	const FxRing<ProfEvent>& events() const noexcept { return m_events; }
+
+	void clear() {
+		m_frames.clear();
+		m_events.clear();
+		m_started = false;
+	}
+
+	static int64 nowNs() noexcept {
+		static const auto epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+private:
+	FxRing<ProfFrame> m_frames{ ProfilerFrames };
+	FxRing<ProfEvent> m_events{ ProfilerMaxEvents };
+	ProfFrame m_current;
+	uint64 m_frameAllocs = 0;
+	bool m_started = false;
+
+	static inline thread_local bool s_threadMeasured = false;
+};
+
+#if defined(_MSC_VER)
+#	define PROFILER_NOINLINE __declspec(noinline)
+#else
+#	define PROFILER_NOINLINE __attribute__((noinline))
+#endif
+
+// スコープの間を1区間として測る
+class ProfileScope {
+public:
+	explicit ProfileScope(ProfZone zone) noexcept
+		: m_zone(zone), m_start(Profiler::Measuring() ? Profiler::nowNs() : -1) {}
+
+	~ProfileScope() {
+		if (m_start >= 0) [[unlikely]] finish();
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	ProfZone m_zone;
+	int64 m_start;
+
+	// 記録側は呼び出し元に展開させない（ホットな関数を太らせないため）
+	PROFILER_NOINLINE void finish() const { Profiler::Get().record(m_zone, m_start, Profiler::nowNs()); }
+};
+
+#define PROFILE_ZONE_CAT2(a, b) a##b
+#define PROFILE_ZONE_CAT(a, b) PROFILE_ZONE_CAT2(a, b)
+#define PROFILE_ZONE(zone) const ProfileScope PROFILE_ZONE_CAT(_profileZone, __LINE__){ zone }
+
+// 保持しているイベント・フレームを Chrome トレース（chrome://tracing / Perfetto で開ける JSON）に書き出す
+bool SaveChromeTrace(s3d::FilePathView path);
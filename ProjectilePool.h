@@ -0,0 +1,134 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Types.h"
+#include "Entities.h"
+
+// ===================== 実弾プール（SoA） =====================
+// 直進弾と放物線弾（迫撃砲）を別々の配列群で持つ。
+// 消滅は末尾との入れ替え（swap-remove）で詰めるので、容量は減らず定常状態では再確保しない。
+namespace ProjectilePoolDetail {
+	template <class T>
+	inline void SwapRemove(s3d::Array<T>& a, size_t i) {
+		if (i + 1 != a.size()) a[i] = a.back();
+		a.pop_back();
+	}
+}
+
+// 直進弾（Bullet / Droplet / Sniper）
+struct StraightProjectiles {
+	// 毎ステップ触る
+	s3d::Array<s3d::Vec2> pos;
+	s3d::Array<s3d::Vec2> prevPos;		// 前ステップの位置（描画補間用）
+	s3d::Array<s3d::Vec2> vel;
+	s3d::Array<double> age;
+	s3d::Array<s3d::Point> targetCell;
+	s3d::Array<uint8> blockedByWalls;
+	// 着弾・描画時のみ
+	s3d::Array<double> life;
+	s3d::Array<double> damage;
+	s3d::Array<double> paint;
+	s3d::Array<double> radius;
+	s3d::Array<ProjKind> kind;
+	s3d::Array<Team> owner;
+
+	size_t size() const noexcept { return pos.size(); }
+	bool isEmpty() const noexcept { return pos.isEmpty(); }
+
+	void push(ProjKind k, Team atk, const s3d::Vec2& p, const s3d::Vec2& v, const s3d::Point& target, bool blocked, double lifeSec, double dmg, double paintDelta, double radiusPx) {
+		pos << p; prevPos << p; vel << v; age << 0.0; targetCell << target; blockedByWalls << (blocked ? 1 : 0);
+		life << lifeSec; damage << dmg; paint << paintDelta; radius << radiusPx; kind << k; owner << atk;
+	}
+
+	void swapRemove(size_t i) {
+		using ProjectilePoolDetail::SwapRemove;
+		SwapRemove(pos, i); SwapRemove(prevPos, i); SwapRemove(vel, i); SwapRemove(age, i); SwapRemove(targetCell, i); SwapRemove(blockedByWalls, i);
+		SwapRemove(life, i); SwapRemove(damage, i); SwapRemove(paint, i); SwapRemove(radius, i); SwapRemove(kind, i); SwapRemove(owner, i);
+	}
+
+	void clear() {
+		pos.clear(); prevPos.clear(); vel.clear(); age.clear(); targetCell.clear(); blockedByWalls.clear();
+		life.clear(); damage.clear(); paint.clear(); radius.clear(); kind.clear(); owner.clear();
+	}
+
+	void reserve(size_t n) {
+		pos.reserve(n); prevPos.reserve(n); vel.reserve(n); age.reserve(n); targetCell.reserve(n); blockedByWalls.reserve(n);
+		life.reserve(n); damage.reserve(n); paint.reserve(n); radius.reserve(n); kind.reserve(n); owner.reserve(n);
+	}
+
+	// 全部の列を順に（スナップショット用）
+	template <class Fn>
+	void forEachColumn(Fn&& fn) {
+		fn(pos); fn(prevPos); fn(vel); fn(age); fn(targetCell); fn(blockedByWalls);
+		fn(life); fn(damage); fn(paint); fn(radius); fn(kind); fn(owner);
+	}
+	template <class Fn>
+	void forEachColumn(Fn&& fn) const { const_cast<StraightProjectiles*>(this)->forEachColumn([&](const auto& col) { fn(col); }); }
+};
+
+// 放物線弾（Mortar）：2次ベジェ曲線に沿って u を 0->1 へ進める
+struct ArcProjectiles {
+	// 毎ステップ触る
+	s3d::Array<s3d::Vec2> pos;
+	s3d::Array<s3d::Vec2> prevPos;		// 前ステップの位置（描画補間用）
+	s3d::Array<double> u;				// 経路の進捗0..1
+	s3d::Array<double> uSpeed;			// 1秒あたりの u の増分（pathSpeed / pathLen）
+	s3d::Array<double> age;
+	s3d::Array<s3d::Vec2> startPos, apexPos, endPos;
+	// 着弾・描画時のみ
+	s3d::Array<s3d::Point> targetCell;
+	s3d::Array<double> life;
+	s3d::Array<int32> aoeRadius;
+	s3d::Array<double> damage;
+	s3d::Array<double> paint;
+	s3d::Array<double> radius;
+	s3d::Array<Team> owner;
+
+	size_t size() const noexcept { return pos.size(); }
+	bool isEmpty() const noexcept { return pos.isEmpty(); }
+
+	void push(Team atk, const s3d::Vec2& start, const s3d::Vec2& apex, const s3d::Vec2& end, double speedPerSec, const s3d::Point& target, double lifeSec, int32 aoe, double dmg, double paintDelta, double radiusPx) {
+		pos << start; prevPos << start; u << 0.0; uSpeed << speedPerSec; age << 0.0;
+		startPos << start; apexPos << apex; endPos << end;
+		targetCell << target; life << lifeSec; aoeRadius << aoe; damage << dmg; paint << paintDelta; radius << radiusPx; owner << atk;
+	}
+
+	void swapRemove(size_t i) {
+		using ProjectilePoolDetail::SwapRemove;
+		SwapRemove(pos, i); SwapRemove(prevPos, i); SwapRemove(u, i); SwapRemove(uSpeed, i); SwapRemove(age, i);
+		SwapRemove(startPos, i); SwapRemove(apexPos, i); SwapRemove(endPos, i);
+		SwapRemove(targetCell, i); SwapRemove(life, i); SwapRemove(aoeRadius, i); SwapRemove(damage, i); SwapRemove(paint, i); SwapRemove(radius, i); SwapRemove(owner, i);
+	}
+
+	void clear() {
+		pos.clear(); prevPos.clear(); u.clear(); uSpeed.clear(); age.clear();
+		startPos.clear(); apexPos.clear(); endPos.clear();
+		targetCell.clear(); life.clear(); aoeRadius.clear(); damage.clear(); paint.clear(); radius.clear(); owner.clear();
+	}
+
+	void reserve(size_t n) {
+		pos.reserve(n); prevPos.reserve(n); u.reserve(n); uSpeed.reserve(n); age.reserve(n);
+		startPos.reserve(n); apexPos.reserve(n); endPos.reserve(n);
+		targetCell.reserve(n); life.reserve(n); aoeRadius.reserve(n); damage.reserve(n); paint.reserve(n); radius.reserve(n); owner.reserve(n);
+	}
+
+	// 全部の列を順に（スナップショット用）
+	template <class Fn>
+	void forEachColumn(Fn&& fn) {
+		fn(pos); fn(prevPos); fn(u); fn(uSpeed); fn(age);
+		fn(startPos); fn(apexPos); fn(endPos);
+		fn(targetCell); fn(life); fn(aoeRadius); fn(damage); fn(paint); fn(radius); fn(owner);
+	}
+	template <class Fn>
+	void forEachColumn(Fn&& fn) const { const_cast<ArcProjectiles*>(this)->forEachColumn([&](const auto& col) { fn(col); }); }
+};
+
+struct ProjectilePool {
+	StraightProjectiles straight;
+	ArcProjectiles arcs;
+
+	size_t size() const noexcept { return straight.size() + arcs.size(); }
+	bool isEmpty() const noexcept { return straight.isEmpty() && arcs.isEmpty(); }
+
+	void clear() { straight.clear(); arcs.clear(); }
+	void reserve(size_t nStraight, size_t nArc) { straight.reserve(nStraight); arcs.reserve(nArc); }
+};
@@ -0,0 +1,102 @@
+﻿#include "RedPlanner.h"
+#include "ThreadPool.h"
+
+using namespace s3d;
+
+namespace {
+	// 買える種類ごとに、置ける場所を何か所か拾う（スポナーは Red だけ）
+	Array<RedPlacement> MakeCandidates(const SimCore& sim, Team side, SmallRNG& rng) {
+		const int money = (side == Team::Red ? sim.moneyRed : sim.moneyBlue);
+		Array<StructureType> types;
+		for (const StructureType t : { StructureType::Basic, StructureType::Sprinkler, StructureType::Mortar, StructureType::Pump, StructureType::Sniper, StructureType::spawner }) {
+			if (t == StructureType::Sniper && sim.stage < 2) continue;
+			if (t == StructureType::spawner && side != Team::Red) continue;
+			if (money >= sim.params.spec(t).cost) types << t;
+		}
+
+		Array<RedPlacement> out;
+		for (const StructureType t : types) {
+			for (int k = 0; k < RedPlannerCellsPerType; ++k) {
+				const auto c = sim.sampleAISpot(side, rng);
+				if (!c) break;
+				if (out.any([&](const RedPlacement& p) { return (p.type == t && p.cell == *c); })) continue;
+				out << RedPlacement{ t, *c };
+			}
+		}
+		return out;
+	}
+
+	// 1試行：コピーに置いて次のターンを回す
+	double Rollout(const SimCore& base, Team side, const RedPlacement& p, uint64 seed) {
+		SimCore s = base;
+		s.eventsEnabled = false;
+		s.events.clear();
+		s.rng.seed(seed);
+		if (side == Team::Red) s.placeRed(p.type, p.cell);
+		else s.placeBlue(p.type, p.cell);
+		s.beginTurn();
+
+		const int steps = (int)(Min(RedPlannerHorizon, SimDuration) / SimFixedDt);
+		for (int i = 0; i < steps; ++i) {
+			if (s.step(SimFixedDt)) break;
+		}
+		const double score = EvaluateForRed(s);
+		return (side == Team::Red ? score : -score);
+	}
+}
+
+double EvaluateForRed(const SimCore& sim) {
+	const double cells = Max(sim.brd.cellCount(), 1);
+	const double territory = ((sim.brd.redTiles - sim.brd.blueTiles) / cells);
+
+	const auto hqLoss = [&](StructureHandle hq) {
+		const Structure* s = sim.structures.get(hq);
+		if (!s) return 1.0;
+		return (1.0 - s->hp / sim.params.spec(StructureType::HQ).maxHP);
+		};
+	const double hq = (hqLoss(sim.blueHQ) - hqLoss(sim.redHQ));
+
+	double score = (territory + RedPlannerHQWeight * hq);
+	if (sim.isBlueLose()) score += 1.0;
+	if (sim.isBlueWin()) score -= 1.0;
+	return score;
+}
+
+Optional<RedPlacement> PlanRedPlacement(const SimCore& sim, SmallRNG& rng, const RedAISettings& settings, double budgetSec, int32* roundsUsed) {
+	return PlanPlacement(sim, Team::Red, rng, settings, budgetSec, roundsUsed);
+}
+
+Optional<RedPlacement> PlanPlacement(const SimCore& sim, Team side, SmallRNG& rng, const RedAISettings& settings, double budgetSec, int32* roundsUsed) {
+	const Array<RedPlacement> candidates = MakeCandidates(sim, side, rng);
+	if (candidates.isEmpty()) return none;
+	if (candidates.size() == 1) return candidates.front();
+
+	const bool fixed = (settings.fixedRollouts > 0);
+	const int maxRounds = (fixed ? settings.fixedRollouts : RedPlannerMaxRollouts);
+	const uint64 baseSeed = rng();
+
+	ThreadPool& pool = SharedThreadPool();
+	const size_t n = candidates.size();
+	Array<double> total(n, 0.0);
+	int rounds = 0;
+
+	// 1ラウンド = 全候補を同じシードで1回ずつ（候補ごとに別スレッド）
+	const Stopwatch sw{ StartImmediately::Yes };
+	while (rounds < maxRounds) {
+		const uint64 seed = (baseSeed + 0x9E3779B97F4A7C15ull * (uint64)(rounds + 1));
+		const auto rollout = [&](size_t i) { total[i] += Rollout(sim, side, candidates[i], seed); };
+		if (settings.parallel) pool.parallelFor(n, rollout);
+		else for (size_t i = 0; i < n; ++i) rollout(i);
+		++rounds;
+
+		// 次のラウンドが予算内に収まりそうなときだけ続ける（最低1ラウンドは回す）
+		if (!fixed && (sw.sF() * (rounds + 1) / rounds) > budgetSec) break;
+	}
+	if (roundsUsed) *roundsUsed = rounds;
+
+	size_t best = 0;
+	for (size_t i = 1; i < n; ++i) {
+		if (total[i] > total[best]) best = i;
+	}
+	return candidates[best];
+}
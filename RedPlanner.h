@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "SimCore.h"
+
+// ===================== 敵の設置プランナー =====================
+// 置ける候補（種類 × セル）を作り、それぞれ SimCore のコピーに置いて次のターンを
+// RedPlannerHorizon 秒ぶん回す。これを乱数を変えて何度も（スレッドプールで並列に）繰り返し、
+// 平均の評価（支配率の差 + HQ ダメージ）がいちばん Red に有利な候補を選ぶ。
+// 同じ試行番号は全候補で同じ乱数を使う（候補どうしの比較のぶれを減らすため）。
+
+struct RedPlacement {
+	StructureType type = StructureType::Basic;
+	s3d::Point cell{ 0, 0 };
+};
+
+// 次に置くものを1つ選ぶ（候補がなければ none）
+//   budgetSec: 思考時間。settings.fixedRollouts > 0 のときは時間を見ずにその回数だけ試す
+//   rng: 候補の抽出と各試行のシードに使う（sim.rng と同じものを渡してよい）
+//   roundsUsed: 実際に回したラウンド数（fixedRollouts にこの値を入れれば同じ結果になる）
+s3d::Optional<RedPlacement> PlanRedPlacement(const SimCore& sim, s3d::SmallRNG& rng, const RedAISettings& settings, double budgetSec, int32* roundsUsed = nullptr);
+
+// 同じことを side 側で（Blue なら左半分に置き、評価は EvaluateForRed の符号を反転。ヘッドレスの Blue AI 用）
+s3d::Optional<RedPlacement> PlanPlacement(const SimCore& sim, Team side, s3d::SmallRNG& rng, const RedAISettings& settings, double budgetSec, int32* roundsUsed = nullptr);
+
+// 試行後の盤面の評価（Red 視点。大きいほど Red に有利）
+double EvaluateForRed(const SimCore& sim);
@@ -0,0 +1,232 @@
+﻿#include "Replay.h"
+
+using namespace s3d;
+
+namespace {
+	void PutVarint(Array<uint8>& out, uint64 v) {
+		while (v >= 0x80) {
+			out << (uint8)(v | 0x80);
+			v >>= 7;
+		}
+		out << (uint8)v;
+	}
+
+	// 読み出し位置を進めながら読む（壊れていれば ok = false）
+	struct VarintReader {
+		const uint8* p;
+		const uint8* end;
+		bool ok = true;
+
+		uint64 next() {
+			uint64 v = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				if (p >= end) { ok = false; return 0; }
+				const uint8 b = *p++;
+				v |= ((uint64)(b & 0x7F) << shift);
+				if (!(b & 0x80)) return v;
+			}
+			ok = false;
+			return 0;
+		}
+		uint8 byte() {
+			if (p >= end) { ok = false; return 0; }
+			return *p++;
+		}
+	};
+
+	bool HasCell(ReplayOp op) {
+		return (op == ReplayOp::Place || op == ReplayOp::Spawn || op == ReplayOp::Move);
+	}
+}
+
+// ===================== ファイル =====================
+Array<uint8> ReplayData::encode() const {
+	Array<uint8> out;
+	out.reserve(16 + inputs.size() * 5);
+	for (int i = 0; i < 4; ++i) out << (uint8)(ReplayFileMagic >> (8 * i));
+	PutVarint(out, ReplayFileVersion);
+	PutVarint(out, seed);
+	PutVarint(out, (uint64)startStage);
+	PutVarint(out, start.size());
+	out.insert(out.end(), start.begin(), start.end());
+	PutVarint(out, inputs.size());
+
+	uint64 prev = 0;
+	for (const auto& in : inputs) {
+		PutVarint(out, in.tick - prev);
+		prev = in.tick;
+		out << (uint8)in.op;
+		if (in.op == ReplayOp::Place) PutVarint(out, (uint64)in.type);
+		if (HasCell(in.op)) {
+			PutVarint(out, (uint64)in.cell.x);
+			PutVarint(out, (uint64)in.cell.y);
+		}
+		if (in.op == ReplayOp::EndTurn) {
+			PutVarint(out, in.rounds.size());
+			for (const int32 r : in.rounds) PutVarint(out, (uint64)r);
+		}
+	}
+	PutVarint(out, endTick - prev);
+	return out;
+}
+
+Optional<ReplayData> ReplayData::Decode(const uint8* data, size_t size) {
+	if (!data || size < 4) return none;
+	uint32 magic = 0;
+	for (int i = 0; i < 4; ++i) magic |= ((uint32)data[i] << (8 * i));
+	if (magic != ReplayFileMagic) return none;
+
+	VarintReader r{ data + 4, data + size };
+	if (r.next() != ReplayFileVersion) return none;
+
+	ReplayData d;
+	d.seed = r.next();
+	d.startStage = (int32)r.next();
+	const uint64 startBytes = r.next();
+	if (!r.ok || startBytes > (uint64)(r.end - r.p)) return none;
+	d.start.assign(r.p, r.p + startBytes);
+	r.p += startBytes;
+	const uint64 count = r.next();
+	if (!r.ok || count > size) return none; // 1入力は最低2バイト
+
+	d.inputs.reserve((size_t)count);
+	uint64 tick = 0;
+	for (uint64 k = 0; k < count && r.ok; ++k) {
+		ReplayInput in;
+		in.tick = (tick += r.next());
+		in.op = (ReplayOp)r.byte();
+		if (in.op > ReplayOp::Retry) return none;
+		if (in.op == ReplayOp::Place) in.type = (int32)r.next();
+		if (HasCell(in.op)) {
+			in.cell.x = (int32)r.next();
+			in.cell.y = (int32)r.next();
+		}
+		if (in.op == ReplayOp::EndTurn) {
+			const uint64 n = r.next();
+			if (n > (uint64)RedPlannerMaxPlacements) return none;
+			for (uint64 j = 0; j < n; ++j) in.rounds << (int32)r.next();
+		}
+		d.inputs << std::move(in);
+	}
+	d.endTick = tick + r.next();
+	if (!r.ok) return none;
+	return d;
+}
+
+bool SaveReplayFile(FilePathView path, const ReplayData& replay) {
+	const Array<uint8> bytes = replay.encode();
+	BinaryWriter writer{ path };
+	if (!writer) return false;
+	writer.write(bytes.data(), bytes.size());
+	return true;
+}
+
+Optional<ReplayData> LoadReplayFile(FilePathView path) {
+	MemoryMappedFileView file{ path };
+	if (!file) return none;
+	const auto mapped = file.mapAll();
+	return ReplayData::Decode(reinterpret_cast<const uint8*>(mapped.data), mapped.size);
+}
+
+// ===================== 再生 =====================
+void ReplayPlayer::restart(SimCore& sim) {
+	m_phase = Phase::Planning;
+	if (m_data.start.isEmpty() || !ReadSnapshot(sim, m_data.start.data(), m_data.start.size(), &m_phase)) {
+		sim.seed = m_data.seed;
+		sim.buildMapForStage(m_data.startStage);
+		m_phase = Phase::Planning;
+	}
+	m_tick = 0;
+	m_next = 0;
+	if (m_keys.isEmpty()) m_keys << Keyframe{ 0, 0, m_phase, WriteSnapshot(sim, m_phase) };
+}
+
+void ReplayPlayer::apply(SimCore& sim, const ReplayInput& in) {
+	switch (in.op) {
+	case ReplayOp::Place:
+		sim.placeBlue((StructureType)in.type, in.cell);
+		break;
+	case ReplayOp::Spawn:
+		sim.spawnFromSpawner(in.cell);
+		break;
+	case ReplayOp::Move:
+		if (!sim.spawnFromSpawner(in.cell)) sim.commandPlayerMove(in.cell);
+		break;
+	case ReplayOp::BeginSim:
+		sim.beginTurn();
+		m_phase = Phase::Simulating;
+		break;
+	case ReplayOp::EndTurn:
+		sim.plannerRoundsScript = in.rounds;
+		sim.plannerRoundsScriptNext = 0;
+		sim.endTurnAndScore();
+		sim.plannerRoundsScript.clear();
+		m_phase = Phase::Planning;
+		break;
+	case ReplayOp::NextStage:
+		sim.gotoNextStage();
+		m_phase = Phase::Planning;
+		break;
+	case ReplayOp::Retry:
+		sim.buildMapForStage(sim.stage);
+		m_phase = Phase::Planning;
+		break;
+	}
+}
+
+bool ReplayPlayer::stepOne(SimCore& sim) {
+	while (m_next < m_data.inputs.size() && m_data.inputs[m_next].tick <= m_tick) {
+		apply(sim, m_data.inputs[m_next++]);
+	}
+	if (m_tick >= m_data.endTick) return false;
+
+	if (m_phase == Phase::Planning) {
+		sim.updatePlayer(SimFixedDt);
+	}
+	else if (m_phase == Phase::Simulating) {
+		if (sim.step(SimFixedDt)) m_phase = Phase::Summary;
+	}
+	else {
+		return false; // 結果画面では tick が進まない（次の入力待ち）
+	}
+	++m_tick;
+
+	if ((m_tick % ReplayKeyframeTicks) == 0 && m_tick > m_keys.back().tick) {
+		m_keys << Keyframe{ m_tick, m_next, m_phase, WriteSnapshot(sim, m_phase) };
+	}
+	return true;
+}
+
+uint64 ReplayPlayer::advance(SimCore& sim, uint64 ticks) {
+	const uint64 start = m_tick;
+	const uint64 target = (m_tick + ticks);
+	while (m_tick < target) {
+		// 最後まで来たか、結果画面のまま次の入力がない（壊れたファイル）
+		if (!stepOne(sim)) break;
+	}
+	// 着いた tick の入力（結果画面からの遷移など）も済ませておく
+	while (m_next < m_data.inputs.size() && m_data.inputs[m_next].tick <= m_tick) {
+		apply(sim, m_data.inputs[m_next++]);
+	}
+	return (m_tick - start);
+}
+
+void ReplayPlayer::seek(SimCore& sim, uint64 tick) {
+	tick = Min(tick, m_data.endTick);
+	if (tick < m_tick) {
+		// 手前で一番近いキーフレームへ戻る
+		size_t k = 0;
+		while ((k + 1) < m_keys.size() && m_keys[k + 1].tick <= tick) ++k;
+		const Keyframe& key = m_keys[k];
+		ReadSnapshot(sim, key.state.data(), key.state.size());
+		m_tick = key.tick;
+		m_next = key.next;
+		m_phase = key.phase;
+	}
+
+	const bool fx = sim.eventsEnabled;
+	sim.eventsEnabled = false;
+	advance(sim, tick - m_tick);
+	sim.eventsEnabled = fx;
+	sim.events.clear();
+}
@@ -0,0 +1,118 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Config.h"
+#include "Types.h"
+#include "SimCore.h"
+#include "Snapshot.h"
+
+// ===================== リプレイ（.iwreplay） =====================
+// 試合シード（またはセーブデータから始めたときはそのスナップショット）と、固定ステップの番号（tick）付きの入力だけを記録する。
+// 同じシード・同じ入力を同じ tick に与えれば SimCore は同じ結果になるので、盤面や弾は保存しない。
+//   tick … Game が固定ステップ（設置中の updatePlayer / 自動戦闘中の step）を1回進めるごとに +1
+//   入力はその tick のステップより前に適用する
+// 可変 dt（Game::fixedTimestep = false）で遊んだ試合は再現できない。
+//
+// ファイル：
+//   "IWRP" / varint version / varint seed / varint 開始ステージ / varint 開始スナップショットのバイト数 + 中身 / varint 入力数
+//   入力ごとに varint tick差分 / uint8 種類 / 種類ごとの varint 引数
+//   最後に varint 終了 tick差分
+
+inline constexpr uint32 ReplayFileMagic = 0x50525749; // "IWRP"
+inline constexpr uint32 ReplayFileVersion = 7;	// 同じ入力で結果が変わる変更（構造物の処理順など）をしたら上げる
+
+enum class ReplayOp : uint8 {
+	Place,		// Blue 設置（type, x, y）
+	Spawn,		// スポナーから出撃（x, y）
+	Move,		// プレイヤー移動先（x, y）
+	BeginSim,	// 自動戦闘開始
+	EndTurn,	// 収益計算して次ターン（Red プランナーのラウンド数の列）
+	NextStage,	// 次のステージへ
+	Retry,		// 同じステージをやり直す
+};
+
+struct ReplayInput {
+	uint64 tick = 0;
+	ReplayOp op = ReplayOp::Place;
+	int32 type = 0;
+	s3d::Point cell{ 0, 0 };
+	s3d::Array<int32> rounds; // EndTurn のみ
+};
+
+struct ReplayData {
+	uint64 seed = 0;
+	int32 startStage = 1;
+	s3d::Array<uint8> start;		// 開始時点のスナップショット（空ならシードから startStage を作る）
+	s3d::Array<ReplayInput> inputs;	// tick 順
+	uint64 endTick = 0;
+
+	s3d::Array<uint8> encode() const;
+	static s3d::Optional<ReplayData> Decode(const uint8* data, size_t size);
+};
+
+// ファイルへの保存・読み込み（読めない・壊れていれば false / none）
+bool SaveReplayFile(s3d::FilePathView path, const ReplayData& replay);
+s3d::Optional<ReplayData> LoadReplayFile(s3d::FilePathView path);
+
+// Game が入力を積む
+class ReplayRecorder {
+public:
+	void begin(uint64 seed, int32 stage, s3d::Array<uint8> start = {}) {
+		m_data = ReplayData{};
+		m_data.seed = seed;
+		m_data.startStage = stage;
+		m_data.start = std::move(start);
+	}
+
+	void record(uint64 tick, ReplayOp op, int32 type = 0, const s3d::Point& cell = s3d::Point{ 0, 0 }, const s3d::Array<int32>& rounds = {}) {
+		m_data.inputs << ReplayInput{ tick, op, type, cell, rounds };
+	}
+
+	// 現在の tick までを1つのリプレイにする
+	ReplayData finish(uint64 endTick) const {
+		ReplayData d = m_data;
+		d.endTick = s3d::Max(endTick, (d.inputs.isEmpty() ? 0 : d.inputs.back().tick));
+		return d;
+	}
+
+private:
+	ReplayData m_data;
+};
+
+// リプレイを SimCore 上で再生する。シークは ReplayKeyframeTicks ごとに取っておいたスナップショットから再計算する
+class ReplayPlayer {
+public:
+	explicit ReplayPlayer(ReplayData data) : m_data(std::move(data)) {}
+
+	// sim を試合開始時点に戻す
+	void restart(SimCore& sim);
+
+	// tick まで進める（後ろに戻るときは手前のキーフレームから）。演出イベントは出さない
+	void seek(SimCore& sim, uint64 tick);
+
+	// ticks だけ進める（演出イベントは sim.eventsEnabled のまま）。実際に進めたステップ数を返す
+	uint64 advance(SimCore& sim, uint64 ticks);
+
+	uint64 tick() const noexcept { return m_tick; }
+	uint64 endTick() const noexcept { return m_data.endTick; }
+	bool isFinished() const noexcept { return (m_tick >= m_data.endTick && m_next >= m_data.inputs.size()); }
+	Phase phase() const noexcept { return m_phase; }
+	const ReplayData& data() const noexcept { return m_data; }
+
+private:
+	struct Keyframe {
+		uint64 tick = 0;
+		size_t next = 0;
+		Phase phase = Phase::Planning;
+		s3d::Array<uint8> state;
+	};
+
+	ReplayData m_data;
+	uint64 m_tick = 0;
+	size_t m_next = 0;	// 次に適用する入力
+	Phase m_phase = Phase::Planning;
+	s3d::Array<Keyframe> m_keys;
+
+	// 1 tick 進める（false: これ以上進めない）
+	bool stepOne(SimCore& sim);
+	void apply(SimCore& sim, const ReplayInput& in);
+};
@@ -0,0 +1,21 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+
+// ===================== Rom の置き場所 =====================
+// テクスチャ・音声・ステージは Rom/（または rom/）の下に置く。
+// 作業ディレクトリから何段か遡って最初に見つかったものを、起動後はじめて使うときに1回だけ決める。
+// 見つからなければ "Rom/"（読み込みはそれぞれ失敗する）
+inline const s3d::FilePath& RomRoot() {
+	static const s3d::FilePath root = [] {
+		for (const auto& r : { U"Rom/", U"rom/", U"../Rom/", U"../rom/", U"../../Rom/", U"../../rom/" }) {
+			if (s3d::FileSystem::IsDirectory(r)) return s3d::FilePath{ r };
+		}
+		return s3d::FilePath{ U"Rom/" };
+		}();
+	return root;
+}
+
+// Rom の下の相対パス -> 実際のパス
+inline s3d::FilePath RomPath(s3d::FilePathView relUnderRom) {
+	return (RomRoot() + relUnderRom);
+}
@@ -0,0 +1,1013 @@
+﻿#include "SimCore.h"
+#include "StageFile.h"
+#include "RedPlanner.h"
+#include "AoeStamp.h"
+
+using namespace s3d;
+
+namespace {
+	// 角度を [-pi, pi] に正規化
+	static double WrapAngle(double a) {
+		while (a <= -Math::Pi) a += Math::TwoPi;
+		while (a > Math::Pi) a -= Math::TwoPi;
+		return a;
+	}
+
+	// 目標へ最大回転量で寄せる
+	static double StepAngleTowards(double current, double target, double maxStep) {
+		const double d = WrapAngle(target - current);
+		const double step = Clamp(d, -maxStep, maxStep);
+		return WrapAngle(current + step);
+	}
+}
+
+// ===================== 演出イベント =====================
+void SimCore::emitParticles(const Vec2& p, const ColorF& col, int n, double vmin, double vmax, double lifeMin, double lifeMax, double s0, double s1) {
+	if (!eventsEnabled) return;
+	SimEvent e;
+	e.kind = SimEventKind::Particles;
+	e.p0 = p; e.col = col; e.count = n;
+	e.speedMin = vmin; e.speedMax = vmax;
+	e.lifeMin = lifeMin; e.lifeMax = lifeMax;
+	e.size0 = s0; e.size1 = s1;
+	events << e;
+}
+
+void SimCore::emitTracer(const Vec2& p0, const Vec2& p1, const ColorF& col, double life) {
+	if (!eventsEnabled) return;
+	SimEvent e;
+	e.kind = SimEventKind::Tracer;
+	e.p0 = p0; e.p1 = p1; e.col = col; e.lifeMax = life;
+	events << e;
+}
+
+void SimCore::emitRing(const Vec2& p, double r, const ColorF& col) {
+	if (!eventsEnabled) return;
+	SimEvent e;
+	e.kind = SimEventKind::Ring;
+	e.p0 = p; e.size0 = r; e.col = col; e.lifeMax = 0.10;
+	events << e;
+}
+
+void SimCore::emitShake(double p, double d) {
+	if (!eventsEnabled) return;
+	SimEvent e;
+	e.kind = SimEventKind::Shake;
+	e.power = p; e.duration = d;
+	events << e;
+}
+
+void SimCore::emitHitStop(double t) {
+	if (!eventsEnabled) return;
+	SimEvent e;
+	e.kind = SimEventKind::HitStop;
+	e.duration = t;
+	events << e;
+}
+
+void SimCore::emitSound(SimSound s, double volume) {
+	if (!eventsEnabled) return;
+	SimEvent e;
+	e.kind = SimEventKind::Sound;
+	e.sound = s; e.volume = volume;
+	events << e;
+}
+
+// ===================== マップ生成 =====================
+// Rom/stages/stageN.iwstage があればそれを、なければ組み込みステージ（map.cpp）を使う
+void SimCore::buildMapForStage(int stageNo) {
+	stage = stageNo;
+
+	// 同じ試合シード・同じステージなら常に同じ乱数列
+	rng.seed(seed ^ (0x9E3779B97F4A7C15ull * (uint64)stageNo));
+
+	MemoryMappedFileView file{ StageFilePath(stageNo) };
+	if (file) {
+		const auto mapped = file.mapAll();
+		if (loadStage(reinterpret_cast<const uint8*>(mapped.data), mapped.size)) return;
+	}
+
+	const Array<uint8> builtin = EncodeBuiltinStage(stageNo);
+	loadStage(builtin.data(), builtin.size());
+}
+
+// ステージデータ（.iwstage の中身）から盤面・構造物・資金を作る。壊れていれば何もせず false
+bool SimCore::loadStage(const uint8* data, size_t size) {
+	const auto view = ParseStage(data, size);
+	if (!view) return false;
+	const StageFileHeader& h = *view->header;
+
+	const Point bHQ{ h.blueHQX, h.blueHQY };
+	const Point rHQ{ h.redHQX, h.redHQY };
+	if (!(0 <= bHQ.x && bHQ.x < h.width && 0 <= bHQ.y && bHQ.y < h.height)) return false;
+	if (!(0 <= rHQ.x && rHQ.x < h.width && 0 <= rHQ.y && rHQ.y < h.height)) return false;
+
+	// 地形・塗りは Board と同じ並びなのでそのまま写す
+	brd.init(h.width, h.height);
+	CopyStageTiles(*view, brd.kind.data(), brd.paint.data());
+	brd.recountOwnership();
+	targets.rebuild(brd);
+	placement.rebuild(brd);
+
+	projectiles.reserve(ProjectileReserveStraight, ProjectileReserveArc);
+	events.reserve(SimEventReserve);
+
+	structures.clear();
+	projectiles.clear();
+	redAgents.clear();
+	events.clear();
+	player.reset();
+	turnCount = 1;
+	simTime = 0.0;
+	simElapsed = 0.0;
+
+	Structure sb; sb.owner = Team::Blue; sb.type = StructureType::HQ; sb.cell = bHQ; sb.hp = params.spec(StructureType::HQ).maxHP;
+	Structure sr; sr.owner = Team::Red;  sr.type = StructureType::HQ; sr.cell = rHQ; sr.hp = params.spec(StructureType::HQ).maxHP;
+	blueHQ = addStructure(sb);
+	redHQ = addStructure(sr);
+
+	// 初期配置の構造物
+	for (int32 k = 0; k < h.structureCount; ++k) {
+		const StageFileStructure& fs = view->structures[k];
+		const Point c{ fs.x, fs.y };
+		const Team owner = (Team)fs.owner;
+		const StructureType t = (StructureType)fs.type;
+		if (owner != Team::Blue && owner != Team::Red) continue;
+		if (t == StructureType::HQ || fs.type < 0 || fs.type > (int32)StructureType::spawner) continue;
+		if (!brd.inBounds(c.x, c.y)) continue;
+		if (brd.kind[brd.idx(c.x, c.y)] != TileKind::Floor) continue;
+		if (brd.redIndex[brd.idx(c.x, c.y)]) continue;
+		if (brd.blueIndex[brd.idx(c.x, c.y)]) continue;
+
+		Structure s; s.owner = owner; s.type = t; s.cell = c; s.hp = params.spec(t).maxHP;
+		addStructure(s);
+	}
+
+	moneyBlue = h.moneyBlue;
+	moneyRed = h.moneyRed;
+	return true;
+}
+
+// 所持金はステージの初期値になる（ステージ側に持たせている）
+void SimCore::gotoNextStage() {
+	buildMapForStage(stage + 1);
+}
+
+// 勝敗条件
+bool SimCore::isBlueWin() const {
+	auto [bp, rp] = Ownership(brd);
+	const bool redHQDead = (redHQ && !structures.contains(redHQ));
+	return (bp >= 0.98) || redHQDead;
+}
+bool SimCore::isBlueLose() const {
+	auto [bp, rp] = Ownership(brd);
+	const bool blueHQDead = (blueHQ && !structures.contains(blueHQ));
+	return (rp >= 0.98) || blueHQDead;
+}
+
+// 敵AIの設置（序盤はランダム、後半のステージはプランナー）
+void SimCore::enemyPlaceAI() {
+	PROFILE_ZONE(ProfZone::EnemyPlaceAI);
+	plannerRoundsLog.clear();
+	if (stage >= redAI.plannerFromStage) enemyPlacePlanned();
+	else enemyPlaceRandom();
+}
+
+// AI が置いてよい範囲：Red は右半分、Blue は左半分（どちらも外周1マスを除く。Blue はバランス調整ツールの Blue AI 用）
+Rect SimCore::aiRegion(Team side) const {
+	if (side == Team::Red) return Rect{ brd.w / 2 + 1, 1, (brd.w - 2) - (brd.w / 2), brd.h - 2 };
+	return Rect{ 1, 1, (brd.w / 2) - 1, brd.h - 2 };
+}
+
+// 右半分（外周1マスを除く）の、Red が置けるセル
+bool SimCore::isRedAISpot(const Point& c) const {
+	return (aiRegion(Team::Red).contains(c) && placement.test(Team::Red, c));
+}
+
+Optional<Point> SimCore::sampleRedAISpot(SmallRNG& r) const {
+	return placement.sample(Team::Red, r, aiRegion(Team::Red));
+}
+
+// 左半分（外周1マスを除く）の、Blue が置けるセル（Red と左右対称）
+bool SimCore::isBlueAISpot(const Point& c) const {
+	return (aiRegion(Team::Blue).contains(c) && placement.test(Team::Blue, c));
+}
+
+Optional<Point> SimCore::sampleAISpot(Team side, SmallRNG& r) const {
+	if (side == Team::Red) return sampleRedAISpot(r);
+	return placement.sample(Team::Blue, r, aiRegion(Team::Blue));
+}
+
+void SimCore::placeRed(StructureType type, const Point& c) {
+	Structure s; s.owner = Team::Red; s.type = type; s.cell = c;
+	s.hp = params.spec(type).maxHP;
+	addStructure(s);
+	moneyRed -= params.spec(type).cost;
+
+	if (type == StructureType::spawner) {
+		spawnEnemyAt(c);
+	}
+}
+
+// 敵が何か1つ置くのに最低限いる所持金
+int SimCore::redMinCost() const {
+	return Min({ params.spec(StructureType::Basic).cost, params.spec(StructureType::Sprinkler).cost, params.spec(StructureType::Mortar).cost, params.costSpawner });
+}
+
+// 買える種類からランダムに選び、ランダムなセルに置く
+void SimCore::enemyPlaceRandom() {
+	int tries = 18;
+	const int minCost = redMinCost();
+	while (tries-- > 0) {
+		if (moneyRed < minCost) break;
+
+		Array<StructureType> bag;
+		const auto affordable = [&](StructureType t) { return (moneyRed >= params.spec(t).cost); };
+		if (affordable(StructureType::Basic))     bag << StructureType::Basic;
+		if (affordable(StructureType::Sprinkler)) bag << StructureType::Sprinkler;
+		if (affordable(StructureType::Mortar))    bag << StructureType::Mortar;
+		if (stage >= 2 && affordable(StructureType::Sniper) && RandomBool(0.35, rng)) bag << StructureType::Sniper;
+		if (affordable(StructureType::Pump) && RandomBool(0.25, rng)) bag << StructureType::Pump;
+		if (moneyRed >= params.costSpawner && RandomBool(0.20, rng)) bag << StructureType::spawner;
+
+		if (bag.isEmpty()) break;
+
+		const StructureType pick = bag.choice(rng);
+		const auto spot = sampleRedAISpot(rng);
+		if (!spot) break;
+		placeRed(pick, *spot);
+	}
+}
+
+// 1つずつ、候補を試しに回して一番良いものを置く（RedPlanner.h）
+void SimCore::enemyPlacePlanned() {
+	const Stopwatch sw{ StartImmediately::Yes };
+	const int minCost = redMinCost();
+	for (int n = 0; n < RedPlannerMaxPlacements; ++n) {
+		if (moneyRed < minCost) break;
+
+		RedAISettings settings = redAI;
+		double budget = 0.0;
+		if (plannerRoundsScriptNext < plannerRoundsScript.size()) {
+			// 記録どおりのラウンド数で回す（リプレイ）
+			settings.fixedRollouts = plannerRoundsScript[plannerRoundsScriptNext++];
+			if (settings.fixedRollouts <= 0) { plannerRoundsLog << 0; break; }
+		}
+		else {
+			// 残り時間を、あと何個置けそうかで割る
+			const int left = Clamp(moneyRed / minCost, 1, RedPlannerMaxPlacements - n);
+			budget = ((redAI.budgetSec - sw.sF()) / left);
+			if (redAI.fixedRollouts <= 0 && budget <= 0.0) { plannerRoundsLog << 0; break; }
+		}
+
+		int32 rounds = 0;
+		const auto pick = PlanRedPlacement(*this, rng, settings, budget, &rounds);
+		plannerRoundsLog << Max(rounds, 1);
+		if (!pick) break;
+		placeRed(pick->type, pick->cell);
+	}
+}
+
+// ===================== ターン進行 =====================
+void SimCore::beginTurn() {
+	simTime = SimDuration;
+	simElapsed = 0.0;
+	projectiles.clear();
+
+	for (auto& s : structures) {
+		const TypeSpec& spec = params.spec(s.type);
+		if (s.owner == Team::Red && s.type == StructureType::spawner) {
+			s.interval = EnemySpawnerInterval;
+			s.nextFire = 0.0;
+		}
+		else if (spec.shots > 0) {
+			s.interval = (SimDuration / spec.shots);
+			s.nextFire = 0.0;
+		}
+		else {
+			s.interval = 9999.0;
+			s.nextFire = 9999.0;
+		}
+	}
+}
+
+bool SimCore::step(double dt) {
+	PROFILE_ZONE(ProfZone::SimStep);
+	bool finished = false;
+
+	simElapsed += dt;
+	simTime -= dt;
+	if (simTime <= 0.0) {
+		simTime = 0.0;
+		finished = true;
+	}
+
+	{
+		PROFILE_ZONE(ProfZone::Turrets);
+
+		// まずは狙い方向の推定と回転補間
+		updateTurretAim(dt);
+
+		// 発射スケジュール（ここでは弾を出すだけで、構造物は増えも減りもしない）
+		for (auto& s : structures) {
+			const TypeSpec& spec = params.spec(s.type);
+			if (spec.shots <= 0) continue;
+			while (simElapsed + 1e-6 >= s.nextFire) {
+				fireOnce(s, s.owner);
+				s.nextFire += s.interval;
+			}
+		}
+	}
+
+	// 実弾
+	updateProjectiles(dt);
+
+	// 敵スポナー出撃
+	// updateEnemySpawnerProduction(dt);
+
+	// 敵ユニット
+	updateRedAgents(dt);
+
+	// プレイヤー
+	updatePlayer(dt);
+
+	// HQ 勝敗判定（中断）
+	if (isBlueLose() || isBlueWin()) {
+		finished = true;
+	}
+	return finished;
+}
+
+void SimCore::endTurnAndScore() {
+	moneyBlue += brd.blueTiles * params.incomePerTile;
+	moneyRed += brd.redTiles * params.incomePerTile;
+
+	int bluePump = 0, redPump = 0;
+	for (const auto& s : structures) {
+		if (s.type != StructureType::Pump) continue;
+		++(s.owner == Team::Blue ? bluePump : redPump);
+	}
+	moneyBlue += bluePump * params.incomePerPump;
+	moneyRed += redPump * params.incomePerPump;
+
+	enemyPlaceAI();
+
+	turnCount += 1;
+}
+
+// ===================== 塗り・ダメージ =====================
+// タイル塗り
+void SimCore::applyPaintAt(const Point& c, double delta) {
+	if (!brd.inBounds(c.x, c.y)) return;
+	const int i = brd.idx(c.x, c.y);
+	brd.setPaint(i, PaintAdd(brd.paint[i], PaintStep(delta)));
+	targets.setPaint(c, brd.paint[i]);
+	placement.update(brd, c);
+}
+
+// 構造物インデックスの書き換え
+void SimCore::setStructureIndex(Team owner, const Point& c, StructureHandle h) {
+	const int i = brd.idx(c.x, c.y);
+	if (owner == Team::Blue) { brd.blueIndex[i] = h; flowDirty = true; }
+	else brd.redIndex[i] = h;
+	targets.setStructure(owner, c, (bool)h);
+	placement.update(brd, c);
+}
+
+StructureHandle SimCore::addStructure(const Structure& s) {
+	const StructureHandle h = structures.insert(s);
+	if (h) setStructureIndex(s.owner, s.cell, h);
+	return h;
+}
+
+void SimCore::removeStructure(Team owner, const Point& c) {
+	const int i = brd.idx(c.x, c.y);
+	const StructureHandle h = (owner == Team::Blue ? brd.blueIndex[i] : brd.redIndex[i]);
+	setStructureIndex(owner, c, StructureHandle{});
+	structures.erase(h);
+}
+
+// 構造体ダメージ（乗っ取り対応）
+void SimCore::damageAt(const Point& c, double dmg, Team attacker) {
+	if (!brd.inBounds(c.x, c.y)) return;
+
+	if (attacker == Team::Blue) {
+		if (Structure* s = structures.get(brd.redIndex[brd.idx(c.x, c.y)])) {
+			s->hp -= dmg;
+			if (s->hp <= 0.0) {
+				// 乗っ取り（HQ は除く）。ここから先 s は使わない
+				const bool wasHQ = (s->type == StructureType::HQ);
+				if (!wasHQ) {
+					captureStructureAt(c, Team::Red, Team::Blue);
+				}
+				else {
+					// HQ は破壊扱い
+					removeStructure(Team::Red, c);
+				}
+
+				// 視覚効果・ペイント（Blue 側）
+				applyPaintAt(c, +0.20);
+				emitParticles(brd.cellCenter(c), HSV{ 210,0.7,1.0 }, 28, 150, 320, 0.30, 0.6, 3, 20);
+				emitShake(8.0, 0.15);
+				emitHitStop(0.04);
+			}
+		}
+	}
+	else if (attacker == Team::Red) {
+		if (Structure* s = structures.get(brd.blueIndex[brd.idx(c.x, c.y)])) {
+			s->hp -= dmg;
+			if (s->hp <= 0.0) {
+				const bool wasHQ = (s->type == StructureType::HQ);
+				if (!wasHQ) {
+					captureStructureAt(c, Team::Blue, Team::Red);
+				}
+				else {
+					// HQ は破壊扱い
+					removeStructure(Team::Blue, c);
+				}
+
+				// 視覚効果・ペイント（Red 側）
+				applyPaintAt(c, -0.20);
+				emitParticles(brd.cellCenter(c), HSV{ 0,0.7,1.0 }, 28, 150, 320, 0.30, 0.6, 3, 20);
+				emitShake(8.0, 0.15);
+				emitHitStop(0.04);
+			}
+		}
+	}
+}
+
+// AoE
+// 係数表（AoeStamp）を行ごとに当てる。盤面の端での切り取りは行ごとに1回
+// 塗りはチャンク内で連続する区間ごとにまとめて足し、しきい値をまたいだセルだけ索引を直す
+// ダメージは敵構造物のあるセル（TargetIndex の occupied）だけ
+void SimCore::applyAOE(const Point& center, int r, double paintDelta, double dmg, Team atk) {
+	if (r < 0) return;
+	const AoeStamp& stamp = GetAoeStamp(r);
+	const float step = (float)(paintDelta * PaintMax);
+	const CellBits& occupied = targets.occupied(atk);
+
+	const int y0 = Max(center.y - r, 0), y1 = Min(center.y + r, brd.h - 1);
+	for (int y = y0; y <= y1; ++y) {
+		const int row = (y - center.y + r);
+		const int hw = stamp.halfWidth[row];
+		const int x0 = Max(center.x - hw, 0), x1 = Min(center.x + hw, brd.w - 1);
+		if (x0 > x1) continue;
+		// 係数の添字 = base + x
+		const int base = (stamp.rowStart[row] - (center.x - hw));
+
+		for (int x = x0; x <= x1;) {
+			const int n = (Min(x1 + 1, ((x >> BoardChunkShift) + 1) << BoardChunkShift) - x);
+			const int i = brd.idx(x, y);
+			const PaintRunResult pr = brd.addPaintRun(i, &stamp.paintScale[base + x], step, n);
+			for (uint32 m = pr.crossed; m; m &= (m - 1)) {
+				const int k = std::countr_zero(m);
+				const Point c{ x + k, y };
+				targets.setPaint(c, brd.paint[i + k]);
+				placement.update(brd, c);
+			}
+			x += n;
+		}
+
+		if (dmg <= 0.0) continue;
+		for (int j = (x0 >> 6); j <= (x1 >> 6); ++j) {
+			// 語は先に取っておく（乗っ取り・破壊でビットが落ちても、この行で見るのは各セル1回だけ）
+			for (uint64 bits = occupied.span(y, j, x0, x1); bits; bits &= (bits - 1)) {
+				const int x = ((j << 6) + std::countr_zero(bits));
+				damageAt(Point{ x, y }, dmg * stamp.damageScale[base + x], atk);
+			}
+		}
+	}
+}
+
+// 乗っ取り本体（持ち主を書き換えて反対側の盤面へ載せ替える。ハンドルは変わらない）
+void SimCore::captureStructureAt(const Point& c, Team from, Team to) {
+	if (!brd.inBounds(c.x, c.y) || from == to) return;
+
+	const int ci = brd.idx(c.x, c.y);
+	const StructureHandle h = (from == Team::Blue ? brd.blueIndex[ci] : brd.redIndex[ci]);
+	Structure* s = structures.get(h);
+	if (!s) return;
+	if (s->type == StructureType::HQ) {
+		// HQ は乗っ取り不可：破壊
+		removeStructure(from, c);
+		return;
+	}
+
+	s->owner = to;
+	s->hp = params.spec(s->type).maxHP;
+
+	// 発射スケジュールを再設定（直近ですぐ撃てるように）
+	const TypeSpec& spec = params.spec(s->type);
+	if (spec.shots > 0) {
+		s->interval = (SimDuration / spec.shots);
+		s->nextFire = simElapsed; // すぐに発射可能
+	}
+	else {
+		s->interval = 9999.0;
+		s->nextFire = 9999.0;
+	}
+
+	// 新オーナー側に載せてから旧側を外す（設置可能セルの並びを変えないよう、途中で空きセルにしない）
+	setStructureIndex(to, c, h);
+	setStructureIndex(from, c, StructureHandle{});
+}
+
+// ===================== 射撃 =====================
+// タレットの狙い更新・回転補間（毎フレーム）
+void SimCore::updateTurretAim(double dt) {
+	for (auto& s : structures) {
+		// スプリンクラーは常時右回転（時計回り）
+		if (s.type == StructureType::Sprinkler) {
+			s.rot = WrapAngle(s.rot + SprinklerSpinSpeed * dt);
+			continue;
+		}
+
+		// 他は「現在の目標角度」へスムーズに寄せる（目標角度は発射時にセット）
+		const double maxStep = TurretTurnSpeed * dt;
+		s.rot = StepAngleTowards(s.rot, s.rotTarget, maxStep);
+	}
+}
+
+// ターゲット選択
+Optional<Point> SimCore::findTargetCell(Team atk, const Point& from, int range, bool turretOnly, bool needsSight) {
+	// 射程内の敵構造物（turretOnly）/ 敵色タイルから1つ。なければ壁以外から1つ
+	// needsSight: 壁で止まる弾なので、射線が壁に遮られるセルは最初から外す
+	const SightMask* mask = (needsSight ? &sight.get(brd, from, range) : nullptr);
+	return targets.pick(atk, from, range, turretOnly, rng, mask);
+}
+
+// 弾を登録
+void SimCore::spawnProjectile(Team atk, const Vec2& muzzle, const Point& targetCell, ProjKind k, bool useArc, bool blocked, bool indirect, int aoe, double dmg, double paint, double speed, double radiusPx) {
+	const Vec2 hitPos = brd.cellCenter(targetCell);
+	const double life = 3.0;
+
+	if (useArc) {
+		const Vec2 mid = (muzzle + hitPos) * 0.5;
+		const double dist = (hitPos - muzzle).length();
+		const double h = 60.0 + 0.25 * dist; // 距離に応じて高く
+		const Vec2 apex = mid + Vec2{ 0, -h };
+		projectiles.arcs.push(atk, muzzle, apex, hitPos, (speed / Max(1.0, dist)), targetCell, life, aoe, dmg, paint, radiusPx);
+	}
+	else {
+		Vec2 dir = (hitPos - muzzle);
+		const double len = dir.length();
+		if (len > 0.0) dir *= (speed / len);
+		else dir = Vec2{ 0,0 };
+		projectiles.straight.push(k, atk, muzzle, dir, targetCell, (blocked && !indirect), life, dmg, paint, radiusPx);
+	}
+
+	// 演出
+	emitParticles(muzzle, TeamColor(atk), 6, 120, 260, 0.08, 0.22, 3, 10);
+	emitTracer(muzzle, muzzle + (hitPos - muzzle).setLength(18.0), TeamColor(atk).withAlpha(0.9), 0.12);
+}
+
+// 1発発射
+void SimCore::fireOnce(Structure& s, Team atk) {
+	const TypeSpec& spec = params.spec(s.type);
+	if (spec.shots <= 0) return;
+
+	const Vec2 muzzle = brd.cellCenter(s.cell);
+
+	// スプリンクラーは散布のみ＆回転は常時スピンに委ねる
+	if (s.type == StructureType::Sprinkler) {
+		emitSound(SimSound::ShotSprinkler, 0.6);
+		for (int i = 0; i < 3; ++i) {
+			Point tc = s.cell + Point{ Random(-(int)spec.range, (int)spec.range, rng), Random(-(int)spec.range, (int)spec.range, rng) };
+			tc.x = limit(tc.x, 0, brd.w - 1);
+			tc.y = limit(tc.y, 0, brd.h - 1);
+			spawnProjectile(atk, muzzle, tc,
+				ProjKind::Droplet, false, false, false, 0, spec.damage * 0.15, spec.paint * 0.9, spec.projSpeed, spec.projRadius * 0.9);
+		}
+		return;
+	}
+
+	Optional<Point> opt = findTargetCell(atk, s.cell, spec.range, spec.targetTurretOnly, (spec.blockedByWalls && !spec.indirect));
+	if (!opt) return;
+	Point target = *opt;
+
+	// ブレ
+	if (spec.spread > 0.05) {
+		target.x += Random(-(int)spec.spread, (int)spec.spread, rng);
+		target.y += Random(-(int)spec.spread, (int)spec.spread, rng);
+		target.x = limit(target.x, 0, brd.w - 1);
+		target.y = limit(target.y, 0, brd.h - 1);
+	}
+
+	// 実際に撃つ方向（ブレ適用後）を目標角度に設定
+	{
+		const Vec2 hitPos = brd.cellCenter(target);
+		const double ang = Math::Atan2((hitPos - muzzle).y, (hitPos - muzzle).x);
+		s.rotTarget = ang;
+	}
+
+	// 発射音
+	if (s.type == StructureType::Mortar) {
+		emitSound(SimSound::ShotMortar, 0.9);
+		spawnProjectile(atk, muzzle, target,
+			ProjKind::Mortar, true, false, true, spec.aoeRadius, spec.damage, spec.paint, spec.projSpeed, spec.projRadius);
+	}
+	else if (s.type == StructureType::Sniper) {
+		emitSound(SimSound::ShotSniper, 0.8);
+		spawnProjectile(atk, muzzle, target,
+			ProjKind::Sniper, false, true, false, 0, spec.damage, spec.paint, spec.projSpeed, spec.projRadius);
+	}
+	else { // Basic
+		emitSound(SimSound::ShotBasic, 0.7);
+		spawnProjectile(atk, muzzle, target,
+			ProjKind::Bullet, false, true, false, 0, spec.damage, spec.paint, spec.projSpeed, spec.projRadius);
+	}
+}
+
+// 弾の進行・衝突処理（消滅した弾は末尾と入れ替えて詰める）
+void SimCore::updateProjectiles(double dt) {
+	PROFILE_ZONE(ProfZone::UpdateProjectiles);
+	// 放物線弾
+	ArcProjectiles& arcs = projectiles.arcs;
+	for (size_t i = 0; i < arcs.size();) {
+		arcs.prevPos[i] = arcs.pos[i];
+		arcs.age[i] += dt;
+		if (arcs.age[i] > arcs.life[i]) {
+			arcs.swapRemove(i); // 消滅
+			continue;
+		}
+
+		arcs.u[i] += arcs.uSpeed[i] * dt;
+		double u = arcs.u[i]; if (u > 1.0) u = 1.0;
+		const double v = (1.0 - u);
+		arcs.pos[i] = (v * v) * arcs.startPos[i] + (2.0 * v * u) * arcs.apexPos[i] + (u * u) * arcs.endPos[i];
+
+		emitTracer(arcs.prevPos[i], arcs.pos[i], TeamColor(arcs.owner[i]), 0.10);
+
+		if (arcs.u[i] >= 1.0) {
+			const Point ic = brd.screenToCell(arcs.endPos[i]).value_or(arcs.targetCell[i]);
+			impactAt(arcs.owner[i], arcs.aoeRadius[i], arcs.damage[i], arcs.paint[i], ic);
+			arcs.swapRemove(i);
+			continue;
+		}
+		++i;
+	}
+
+	// 直進弾（1ステップの移動を半タイルごとに分割して判定）
+	StraightProjectiles& st = projectiles.straight;
+	const double subLen = (brd.tileSize * 0.5);
+	for (size_t i = 0; i < st.size();) {
+		st.prevPos[i] = st.pos[i];
+		st.age[i] += dt;
+		if (st.age[i] > st.life[i]) {
+			st.swapRemove(i); // 消滅
+			continue;
+		}
+
+		const Vec2 remain = st.vel[i] * dt;
+		const int subSteps = Max(1, (int)Ceil(remain.length() / subLen));
+		const Vec2 step = remain / (double)subSteps;
+		Vec2 pos = st.pos[i];
+		Vec2 traceEnd = pos;
+		bool hit = false;
+		for (int k = 0; k < subSteps; ++k) {
+			const Vec2 prev = pos;
+			pos += step;
+
+			if (st.blockedByWalls[i]) {
+				if (const auto oc = brd.posToCell(pos)) {
+					const TileKind kind = brd.kind[brd.idx(oc->x, oc->y)];
+					if (kind == TileKind::Wall) {
+						const Point ic = brd.posToCell(prev).value_or(*oc);
+						impactAt(st.owner[i], 0, st.damage[i], st.paint[i], ic);
+						hit = true;
+						break;
+					}
+				}
+				else {
+					hit = true; break;
+				}
+			}
+			if (const auto tc = brd.posToCell(pos)) {
+				if (tc->x == st.targetCell[i].x && tc->y == st.targetCell[i].y) {
+					impactAt(st.owner[i], 0, st.damage[i], st.paint[i], *tc);
+					hit = true;
+					break;
+				}
+			}
+			traceEnd = pos;
+		}
+		st.pos[i] = pos;
+
+		// 軌跡は分割ごとではなく 1ステップ分をまとめて 1本
+		if (traceEnd != st.prevPos[i]) emitTracer(st.prevPos[i], traceEnd, TeamColor(st.owner[i]), 0.08);
+
+		if (hit || !brd.gridRect.intersects(pos)) {
+			st.swapRemove(i); // 着弾 or 盤面外で消滅
+			continue;
+		}
+		++i;
+	}
+}
+
+// 着弾時の効果
+void SimCore::impactAt(Team owner, int aoeRadius, double damage, double paint, const Point& ic) {
+	if (!brd.inBounds(ic.x, ic.y)) return;
+
+	if (aoeRadius > 0) {
+		applyAOE(ic, aoeRadius, (owner == Team::Blue ? +paint : -paint), damage, owner);
+		emitParticles(brd.cellCenter(ic), (owner == Team::Blue ? HSV{ 210,0.8,1.0 } : HSV{ 0,0.8,1.0 }), 18, 140, 260, 0.25, 0.6, 4, 18);
+		emitRing(brd.cellCenter(ic), 16.0 + aoeRadius * brd.tileSize * 0.25, TeamColor(owner).withAlpha(0.6));
+		emitShake(7.0, 0.12);
+		emitHitStop(0.02);
+	}
+	else {
+		applyPaintAt(ic, (owner == Team::Blue ? +paint : -paint));
+		damageAt(ic, damage, owner);
+		emitParticles(brd.cellCenter(ic), (owner == Team::Blue ? HSV{ 210,0.8,1.0 } : HSV{ 0,0.8,1.0 }), 10, 120, 220, 0.20, 0.45, 3, 12);
+		emitShake(3.0, 0.06);
+	}
+}
+
+// ===================== プレイヤー操作・敵AI（体当たり） =====================
+
+bool SimCore::isWallAt(const Vec2& p) const {
+	if (const auto oc = brd.posToCell(p)) {
+		return (brd.kind[brd.idx(oc->x, oc->y)] == TileKind::Wall);
+	}
+	return true; // 盤面外は壁扱い
+}
+
+void SimCore::moveWithCollide(Actor& a, const Vec2& delta) {
+	if (!a.alive) return;
+
+	// X方向
+	Vec2 np = a.pos + Vec2{ delta.x, 0 };
+	const double minX = brd.gridRect.x + a.radius;
+	const double maxX = brd.gridRect.x + brd.gridRect.w - a.radius;
+	np.x = Clamp(np.x, minX, maxX);
+	if (!isWallAt(np)) a.pos.x = np.x;
+
+	// Y方向
+	np = a.pos + Vec2{ 0, delta.y };
+	const double minY = brd.gridRect.y + a.radius;
+	const double maxY = brd.gridRect.y + brd.gridRect.h - a.radius;
+	np.y = Clamp(np.y, minY, maxY);
+	if (!isWallAt(np)) a.pos.y = np.y;
+}
+
+// 味方スポナーのセルなら出撃
+bool SimCore::spawnFromSpawner(const Point& c) {
+	if (!brd.inBounds(c.x, c.y)) return false;
+	const Structure* s = structures.get(brd.blueIndex[brd.idx(c.x, c.y)]);
+	if (s && s->type == StructureType::spawner) {
+		spawnPlayerAt(s->cell);
+		emitParticles(brd.cellCenter(s->cell), HSV{ 210,0.8,1.0 }, 14, 120, 240, 0.18, 0.35, 3, 12);
+		return true;
+	}
+	return false;
+}
+
+// 移動先指定（壁をクリックしたら手前で止める）
+void SimCore::commandPlayerMove(const Point& c) {
+	if (!player || !player->alive) return;
+	if (!brd.inBounds(c.x, c.y)) return;
+	Point fromC = brd.posToCell(player->pos).value_or(c);
+	Point dest = c;
+	if (brd.kind[brd.idx(c.x, c.y)] == TileKind::Wall) {
+		dest = RaycastUntilWall(brd, fromC, c);
+	}
+	player->moveTarget = brd.cellCenter(dest);
+	player->path.clear();
+	player->pathNext = 0;
+
+	// 壁を回り込む経路の曲がり角（届かなければこれまで通りまっすぐ向かう）
+	if (const auto cells = paths.find(brd, fromC, dest)) {
+		for (size_t i = 0; (i + 1) < cells->size(); ++i) {
+			player->path << brd.cellCenter((*cells)[i]);
+		}
+	}
+}
+
+void SimCore::spawnPlayerAt(const Point& c) {
+	Actor a;
+	a.pos = brd.cellCenter(c);
+	a.lastPos = a.pos;
+	a.prevPos = a.pos;
+	a.radius = PlayerRadius;
+	a.speed = PlayerSpeed;
+	a.hp = HPPlayer;
+	a.alive = true;
+	a.moveTarget.reset();
+	a.life = PlayerLifetime;
+	a.age = 0.0;
+	player = a;
+}
+
+void SimCore::playerExplodeAt(const Point& cell) {
+	const Vec2 center = brd.cellCenter(cell);
+	applyAOE(cell, PlayerExplodeRadius, +PlayerExplodePaint, PlayerExplodeDamage, Team::Blue);
+	emitParticles(center, HSV{ 210,0.85,1.0 }, 36, 180, 360, 0.30, 0.70, 5, 22);
+	emitParticles(center, ColorF{ 1.0, 0.95 }, 18, 120, 260, 0.12, 0.25, 4, 14);
+	emitShake(PlayerExplodeShakePow, PlayerExplodeShakeDur);
+	emitHitStop(PlayerExplodeHitstop);
+	if (player) {
+		player->alive = false;
+	}
+}
+
+// 移動経路のセルを塗る
+void SimCore::paintTrailByMove(const Vec2& from, const Vec2& to, double dt) {
+	const auto c0 = brd.posToCell(from);
+	const auto c1 = brd.posToCell(to);
+	if (!c0 || !c1) return;
+
+	const double total = PlayerPaintPerSecond * dt;
+	const double per = total / (double)LineCellCount(*c0, *c1);
+
+	ForEachLineCell(*c0, *c1, [&](const Point& cell) {
+		if (brd.inBounds(cell.x, cell.y) && brd.kind[brd.idx(cell.x, cell.y)] != TileKind::Wall) {
+			applyPaintAt(cell, +per);
+		}
+		});
+}
+
+// プレイヤー更新
+void SimCore::updatePlayer(double dt) {
+	PROFILE_ZONE(ProfZone::UpdatePlayer);
+	if (!player || !player->alive) return;
+	player->prevPos = player->pos;
+
+	if (player->moveTarget) {
+		// 曲がり角を越えたら残りの距離で次の区間へ。塗りは進んだ距離の割合で区間ごとに分ける
+		const double fullStep = player->speed * dt;
+		double stepLen = fullStep;
+		while (player->moveTarget) {
+			const bool last = (player->pathNext >= player->path.size());
+			const Vec2 wp = (last ? *player->moveTarget : player->path[player->pathNext]);
+			Vec2 dir = (wp - player->pos);
+			const double dist = dir.length();
+			const Vec2 prev = player->pos;
+			if (dist <= stepLen || dist <= 1e-3) {
+				player->pos = wp;
+				if (last) {
+					player->moveTarget.reset();
+					player->path.clear();
+					player->pathNext = 0;
+					paintTrailByMove(prev, player->pos, dt * (fullStep > 0.0 ? stepLen / fullStep : 1.0));
+					break;
+				}
+				++player->pathNext;
+				paintTrailByMove(prev, player->pos, dt * (fullStep > 0.0 ? dist / fullStep : 0.0));
+				stepLen -= dist;
+			}
+			else {
+				dir = dir.setLength(stepLen);
+				moveWithCollide(*player, dir);
+				paintTrailByMove(prev, player->pos, dt * (fullStep > 0.0 ? stepLen / fullStep : 1.0));
+				break;
+			}
+		}
+	}
+
+	if (const auto oc = brd.posToCell(player->pos)) {
+		if (brd.redIndex[brd.idx(oc->x, oc->y)]) {
+			playerExplodeAt(*oc);
+			return;
+		}
+	}
+
+	player->age += dt;
+	if (player->life > 0.0 && player->age >= player->life) {
+		emitParticles(player->pos, HSV{ 210,0.7,1.0 }, 12, 80, 160, 0.18, 0.36, 3, 12);
+		player->alive = false;
+	}
+
+	player->lastPos = player->pos;
+}
+
+// ===== 敵ユニット（AI） =====
+void SimCore::spawnEnemyAt(const Point& c) {
+	Actor a;
+	a.pos = brd.cellCenter(c);
+	a.lastPos = a.pos;
+	a.prevPos = a.pos;
+	a.radius = EnemyRadius;
+	a.speed = EnemySpeed;
+	a.hp = HPEnemy;
+	a.alive = true;
+	a.moveTarget.reset();
+	a.life = EnemyLifetime;
+	a.age = 0.0;
+	redAgents << a;
+	emitParticles(a.pos, HSV{ 0,0.8,1.0 }, 10, 100, 200, 0.15, 0.30, 3, 12);
+}
+
+void SimCore::enemyExplodeAt(const Point& cell) {
+	const Vec2 center = brd.cellCenter(cell);
+	applyAOE(cell, EnemyExplodeRadius, -EnemyExplodePaint, EnemyExplodeDamage, Team::Red);
+	emitParticles(center, HSV{ 0,0.85,1.0 }, 28, 160, 320, 0.25, 0.60, 5, 20);
+	emitShake(EnemyExplodeShakePow, EnemyExplodeShakeDur);
+	emitHitStop(EnemyExplodeHitstop);
+}
+
+// 誘導場を下る向き（壁を回り込んで一番近い Blue 構造物へ）
+Vec2 SimCore::enemySeekTargetVec(const Actor& e) const {
+	return flow.direction(brd, e.pos);
+}
+
+void SimCore::updateEnemySpawnerProduction(double dt) {
+	(void)dt;
+	for (auto& s : structures) {
+		if (s.owner != Team::Red || s.type != StructureType::spawner) continue;
+		while (simElapsed + 1e-6 >= s.nextFire) {
+			spawnEnemyAt(s.cell);
+			s.nextFire += s.interval;
+		}
+	}
+}
+
+void SimCore::updateRedAgents(double dt) {
+	PROFILE_ZONE(ProfZone::UpdateRedAgents);
+	if (redAgents.isEmpty()) return;
+
+	if (flowDirty || flow.isStale(brd)) {
+		flow.rebuild(brd);
+		flowDirty = false;
+	}
+
+	// 生き残りをその場で前に詰める（並びは変えない。容量は減らないので定常状態では確保しない）
+	size_t keep = 0;
+	for (size_t k = 0; k < redAgents.size(); ++k) {
+		Actor& e = redAgents[k];
+		if (!e.alive) continue;
+
+		e.prevPos = e.pos;
+		e.age += dt;
+		if (e.life > 0.0 && e.age >= e.life) {
+			emitParticles(e.pos, HSV{ 0,0.6,1.0 }, 8, 80, 160, 0.15, 0.30, 3, 10);
+			e.alive = false;
+			continue;
+		}
+
+		Vec2 to = enemySeekTargetVec(e);
+		if (to.lengthSq() > 1e-4) {
+			Vec2 step = to.setLength(e.speed * dt);
+			moveWithCollide(e, step);
+		}
+
+		bool exploded = false;
+		if (const auto oc = brd.posToCell(e.pos)) {
+			if (brd.blueIndex[brd.idx(oc->x, oc->y)]) {
+				enemyExplodeAt(*oc);
+				e.alive = false;
+				exploded = true;
+			}
+		}
+
+		if (e.alive && !exploded) {
+			if (keep != k) redAgents[keep] = std::move(e);
+			++keep;
+		}
+	}
+
+	redAgents.resize(keep);
+}
+
+// ===================== 設置 =====================
+// 置けるか判定
+bool SimCore::canPlace(Team side, StructureType type, const Point& c, String& reason) const {
+	if (!brd.inBounds(c.x, c.y)) { reason = U"範囲外"; return false; }
+	const int i = brd.idx(c.x, c.y);
+	if (brd.kind[i] != TileKind::Floor) { reason = U"ここには置けません"; return false; }
+
+	if (side == Team::Blue) {
+		if (brd.blueIndex[i]) { reason = U"味方構造物あり"; return false; }
+		if (brd.redIndex[i]) { reason = U"敵構造物あり"; return false; }
+	}
+	else {
+		if (brd.redIndex[i]) { reason = U"自軍構造物あり"; return false; }
+		if (brd.blueIndex[i]) { reason = U"敵構造物あり"; return false; }
+	}
+
+	const bool own = (side == Team::Blue ? (brd.paint[i] > PaintBlueish) : (brd.paint[i] < PaintRedish));
+	if (!own) { reason = U"自軍インク外"; return false; }
+
+	const int cost = params.spec(type).cost;
+	if (side == Team::Blue) {
+		if (moneyBlue < cost) { reason = U"$不足"; return false; }
+	}
+	else {
+		if (moneyRed < cost) { reason = U"$不足(敵)"; return false; }
+	}
+
+	reason = U"OK";
+	return true;
+}
+bool SimCore::isPlaceable(Team side, StructureType type, const Point& c) const {
+	if (!brd.inBounds(c.x, c.y) || !placement.test(side, c)) return false;
+	return ((side == Team::Blue ? moneyBlue : moneyRed) >= params.spec(type).cost);
+}
+
+// プレイヤー設置
+bool SimCore::placeBlue(StructureType type, const Point& c) {
+	String r; if (!canPlace(Team::Blue, type, c, r)) return false;
+	Structure s; s.owner = Team::Blue; s.type = type; s.cell = c; s.hp = params.spec(type).maxHP;
+	addStructure(s);
+	moneyBlue -= params.spec(type).cost;
+	return true;
+}
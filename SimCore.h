@@ -0,0 +1,186 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Config.h"
+#include "Utils.h"
+#include "Types.h"
+#include "Entities.h"
+#include "Board.h"
+#include "StructureMap.h"
+#include "GridUtils.h"
+#include "SimEvents.h"
+#include "ProjectilePool.h"
+#include "TargetIndex.h"
+#include "FlowField.h"
+#include "GridPath.h"
+#include "PlacementMap.h"
+#include "Profiler.h"
+#include "SimParams.h"
+
+// 敵の設置AIの設定
+struct RedAISettings {
+	int plannerFromStage = RedPlannerFromStage;	// このステージ以降はプランナーで置く
+	double budgetSec = RedPlannerBudgetSec;		// 1ターンの思考時間
+	int fixedRollouts = 0;						// > 0 なら時間ではなく候補ごとの試行回数で打ち切る（結果が決定的になる）
+	bool parallel = true;						// false なら試行を呼び出し側のスレッドだけで回す（試合そのものを並列に回すとき）
+};
+
+// ===================== シミュレーション本体 =====================
+// 盤面・構造物・弾・ユニット・経済だけを持ち、ウィンドウ/GPU/音声に依存しない。
+// 演出（パーティクル・シェイク・効果音など）は events に積み、Game 側が取り出して再生する。
+class SimCore {
+public:
+	Board brd;
+
+	// ステージ
+	int stage = 1;
+
+	// 経済
+	int moneyBlue = 200;
+	int moneyRed = 1040;
+	int turnCount = 1;
+
+	// 構造物（両チーム。どちらの側かは Structure::owner、セルからは brd.blueIndex / redIndex のハンドルで引く）
+	StructureMap structures;
+
+	// HQ（壊れたらハンドルが古くなる）
+	StructureHandle blueHQ;
+	StructureHandle redHQ;
+
+	// シミュレーション
+	double simTime = 0.0;
+	double simElapsed = 0.0;
+
+	// プレイヤー
+	s3d::Optional<Actor> player;
+
+	// 敵ユニット（AI）
+	s3d::Array<Actor> redAgents;
+
+	// 敵ユニットの誘導場（Blue 構造物の配置が変わったら flowDirty を立て、次に使うとき作り直す）
+	FlowField flow;
+	bool flowDirty = true;
+
+	// プレイヤーのクリック移動の経路探索
+	GridPathfinder paths;
+
+	// 射撃ターゲット索引（塗り・構造物配置と同期）
+	TargetIndex targets;
+	// 壁で止まる弾の砲台の射線（壁が変わったら作り直す）
+	LineOfSightCache sight;
+	// 設置できるセル（塗り・構造物配置と同期）
+	PlacementMap placement;
+
+	// 実弾（直進 / 放物線の SoA プール）
+	ProjectilePool projectiles;
+
+	// バランス値（構造物の仕様・収入。GetSpec ではなくこちらを見る）
+	SimParams params;
+
+	// 乱数（試合シードから決まる。グローバルの Random は使わない）
+	uint64 seed = 0;
+	s3d::SmallRNG rng;
+
+	// 演出イベント（false のときは積まない：ヘッドレス実行用）
+	s3d::Array<SimEvent> events;
+	bool eventsEnabled = true;
+
+	// 敵の設置AI
+	RedAISettings redAI;
+	// プランナーが設置1回ごとに回したラウンド数（直近の endTurnAndScore のぶん。0 = 時間切れで打ち切り）
+	// 思考時間で打ち切った結果をリプレイで再現するため、plannerRoundsScript に同じ列を入れると時間を見ずにその通り回す
+	s3d::Array<int32> plannerRoundsLog;
+	s3d::Array<int32> plannerRoundsScript;
+	size_t plannerRoundsScriptNext = 0;
+
+public:
+	// マップ生成（seed とステージ番号から乱数を初期化し直す）
+	// Rom/stages/stageN.iwstage があれば読み、なければ組み込みステージを使う
+	void buildMapForStage(int stageNo);
+	// .iwstage の中身から盤面を作る（壊れていれば false で何も変えない）
+	bool loadStage(const uint8* data, size_t size);
+	void gotoNextStage();
+
+	// 勝敗
+	bool isBlueWin() const;
+	bool isBlueLose() const;
+
+	// ターン進行
+	void beginTurn();
+	bool step(double dt); // true: ターン終了（時間切れ・勝敗確定）。決定的に進めるには SimFixedDt を渡す
+	void endTurnAndScore();
+
+	// 置けるか判定・設置（isPlaceable は理由なしの O(1) 版。毎フレームの判定はこちら）
+	bool canPlace(Team side, StructureType type, const s3d::Point& c, s3d::String& reason) const;
+	bool isPlaceable(Team side, StructureType type, const s3d::Point& c) const;
+	bool placeBlue(StructureType type, const s3d::Point& c);
+
+	// 敵の設置（AI 用：置ける場所か / 置ける場所から1つ / 置いて代金を払う）
+	s3d::Rect aiRegion(Team side) const;
+	bool isRedAISpot(const s3d::Point& c) const;
+	s3d::Optional<s3d::Point> sampleRedAISpot(s3d::SmallRNG& rng) const;
+	void placeRed(StructureType type, const s3d::Point& c);
+	int redMinCost() const;
+	// Blue 側の同じもの（ヘッドレスで Blue も AI に置かせるとき用。置くのは placeBlue）
+	bool isBlueAISpot(const s3d::Point& c) const;
+	s3d::Optional<s3d::Point> sampleAISpot(Team side, s3d::SmallRNG& rng) const;
+
+	// プレイヤー操作（入力は Game 側で解釈して渡す）
+	bool spawnFromSpawner(const s3d::Point& c);
+	void commandPlayerMove(const s3d::Point& c);
+	void updatePlayer(double dt);
+
+private:
+	// マイクロベンチマーク（Headless/Bench.cpp）から内部の処理を1つずつ呼ぶ
+	friend struct SimBench;
+
+	// 演出イベント
+	void emitParticles(const s3d::Vec2& p, const s3d::ColorF& col, int n, double vmin = 80, double vmax = 180, double lifeMin = 0.25, double lifeMax = 0.6, double s0 = 3, double s1 = 14);
+	void emitTracer(const s3d::Vec2& p0, const s3d::Vec2& p1, const s3d::ColorF& col, double life);
+	void emitRing(const s3d::Vec2& p, double r, const s3d::ColorF& col);
+	void emitShake(double p, double d);
+	void emitHitStop(double t);
+	void emitSound(SimSound s, double volume);
+
+	// 敵AI 設置
+	void enemyPlaceAI();
+	void enemyPlaceRandom();
+	void enemyPlacePlanned();
+
+	// 塗り・ダメージ
+	void applyPaintAt(const s3d::Point& c, double delta);
+	void damageAt(const s3d::Point& c, double dmg, Team attacker);
+	void applyAOE(const s3d::Point& center, int r, double paintDelta, double dmg, Team atk);
+
+	// 構造物インデックスの書き換え（ターゲット索引も同期）
+	void setStructureIndex(Team owner, const s3d::Point& c, StructureHandle h);
+	// 追加して盤面に載せる / 盤面から降ろして取り除く
+	StructureHandle addStructure(const Structure& s);
+	void removeStructure(Team owner, const s3d::Point& c);
+
+	// 構造物乗っ取り
+	void captureStructureAt(const s3d::Point& c, Team from, Team to);
+
+	// タレットの狙い更新・回転補間
+	void updateTurretAim(double dt);
+
+	// 射撃系
+	s3d::Optional<s3d::Point> findTargetCell(Team atk, const s3d::Point& from, int range, bool turretOnly, bool needsSight);
+	void spawnProjectile(Team atk, const s3d::Vec2& muzzle, const s3d::Point& targetCell, ProjKind k, bool useArc, bool blocked, bool indirect, int aoe, double dmg, double paint, double speed, double radiusPx);
+	void fireOnce(Structure& s, Team atk);
+	void updateProjectiles(double dt);
+	void impactAt(Team owner, int aoeRadius, double damage, double paint, const s3d::Point& ic);
+
+	// プレイヤー・敵ユニット
+	bool isWallAt(const s3d::Vec2& p) const;
+	void moveWithCollide(Actor& a, const s3d::Vec2& delta);
+
+	void spawnPlayerAt(const s3d::Point& c);
+	void playerExplodeAt(const s3d::Point& cell);
+	void paintTrailByMove(const s3d::Vec2& from, const s3d::Vec2& to, double dt);
+
+	void spawnEnemyAt(const s3d::Point& c);
+	void enemyExplodeAt(const s3d::Point& cell);
+	s3d::Vec2 enemySeekTargetVec(const Actor& e) const;
+	void updateEnemySpawnerProduction(double dt);
+	void updateRedAgents(double dt);
+};
@@ -0,0 +1,28 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+
+// ===================== シミュレーション → 演出イベント =====================
+// SimCore は描画・音声を直接呼ばず、ここに積んで Game 側に任せる
+enum class SimEventKind : int32 {
+	Particles,	// パーティクル放出
+	Tracer,		// 弾跡
+	Ring,		// 着弾リング
+	Shake,		// 画面振動
+	HitStop,	// ヒットストップ
+	Sound,		// 効果音
+};
+
+enum class SimSound : int32 { ShotBasic, ShotSprinkler, ShotSniper, ShotMortar };
+
+struct SimEvent {
+	SimEventKind kind = SimEventKind::Particles;
+	s3d::Vec2 p0, p1;			// 位置（Tracer は始点/終点）
+	s3d::ColorF col;
+	int32 count = 0;			// パーティクル数
+	double speedMin = 0, speedMax = 0;
+	double lifeMin = 0, lifeMax = 0;	// Tracer / Ring は lifeMax のみ使用
+	double size0 = 0, size1 = 0;		// Ring は size0 を半径に使用
+	double power = 0, duration = 0;		// Shake / HitStop
+	SimSound sound = SimSound::ShotBasic;
+	double volume = 1.0;
+};
@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include <array>
+#include "Config.h"
+#include "Types.h"
+
+// ===================== バランス値（試合ごと） =====================
+// 構造物の仕様と収入を SimCore ごとに持つ。既定値は Config.h / GetSpec と同じ。
+// ゲーム本体は既定値のまま使い、バランス調整ツール（Headless/Tournament.cpp）が書き換えて総当たりする。
+struct SimParams {
+	// StructureType::Basic .. HQ の仕様（スポナーは GetSpec と同じく Basic の仕様を使う）
+	std::array<TypeSpec, (size_t)StructureType::HQ + 1> specs;
+	int costSpawner = CostSpawner;	// 敵がスポナーを選べる所持金
+	int incomePerTile = IncomePerTile;
+	int incomePerPump = IncomePerPump;
+
+	SimParams() {
+		for (size_t i = 0; i < specs.size(); ++i) specs[i] = GetSpec((StructureType)i);
+	}
+
+	const TypeSpec& spec(StructureType t) const noexcept { return specs[slot(t)]; }
+	TypeSpec& spec(StructureType t) noexcept { return specs[slot(t)]; }
+
+	// "basic.cost" / "mortar.damage" / "income.tile" のような名前で1つ書き換える（知らない名前なら false）
+	//   種類: basic / sprinkler / pump / sniper / mortar / hq
+	//   項目: cost / hp / range / shots / damage / paint / aoe / spread
+	//   そのほか: spawner.cost / income.tile / income.pump
+	bool set(s3d::StringView key, double value) {
+		if (key == U"spawner.cost") { costSpawner = (int)value; return true; }
+		if (key == U"income.tile") { incomePerTile = (int)value; return true; }
+		if (key == U"income.pump") { incomePerPump = (int)value; return true; }
+
+		const size_t dot = key.indexOf(U'.');
+		if (dot >= key.size()) return false;
+		const s3d::StringView type = key.substr(0, dot);
+		const s3d::StringView field = key.substr(dot + 1);
+
+		static constexpr std::array<const char32*, (size_t)StructureType::HQ + 1> TypeNames{
+			U"basic", U"sprinkler", U"pump", U"sniper", U"mortar", U"hq",
+		};
+		for (size_t i = 0; i < TypeNames.size(); ++i) {
+			if (type != TypeNames[i]) continue;
+			TypeSpec& s = specs[i];
+			if (field == U"cost") s.cost = (int)value;
+			else if (field == U"hp") s.maxHP = value;
+			else if (field == U"range") s.range = (int)value;
+			else if (field == U"shots") s.shots = (int)value;
+			else if (field == U"damage") s.damage = value;
+			else if (field == U"paint") s.paint = value;
+			else if (field == U"aoe") s.aoeRadius = (int)value;
+			else if (field == U"spread") s.spread = value;
+			else return false;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	static size_t slot(StructureType t) noexcept {
+		return ((int32)t >= 0 && t <= StructureType::HQ ? (size_t)t : (size_t)StructureType::Basic);
+	}
+};
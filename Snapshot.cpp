@@ -0,0 +1,287 @@
+﻿#include "Snapshot.h"
+
+using namespace s3d;
+
+namespace {
+	void Append(Array<uint8>& out, const void* p, size_t bytes) {
+		if (bytes == 0) return;
+		const size_t at = out.size();
+		out.resize(at + bytes);
+		std::memcpy(out.data() + at, p, bytes);
+	}
+
+	template <class T>
+	void AppendArray(Array<uint8>& out, const Array<T>& a) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		Append(out, a.data(), a.size() * sizeof(T));
+	}
+
+	// 読み出し位置（範囲外を読もうとしたら ok = false のまま先へは進まない）
+	struct ByteCursor {
+		const uint8* p;
+		const uint8* end;
+		bool ok = true;
+
+		const uint8* take(size_t bytes) {
+			if (!ok || (size_t)(end - p) < bytes) { ok = false; return nullptr; }
+			const uint8* at = p;
+			p += bytes;
+			return at;
+		}
+	};
+
+	template <class T>
+	void CopyTo(Array<T>& a, const uint8* src, size_t n) {
+		a.resize(n);
+		if (n) std::memcpy(a.data(), src, n * sizeof(T));
+	}
+
+	SnapshotActor ToRecord(const Actor& a) {
+		SnapshotActor r;
+		r.pos = a.pos; r.lastPos = a.lastPos; r.prevPos = a.prevPos;
+		r.moveTarget = a.moveTarget.value_or(Vec2{ 0, 0 });
+		r.radius = a.radius; r.speed = a.speed; r.hp = a.hp;
+		r.life = a.life; r.age = a.age;
+		r.alive = (a.alive ? 1 : 0);
+		r.hasMoveTarget = (a.moveTarget ? 1 : 0);
+		r.pathCount = (uint32)a.path.size();
+		r.pathNext = (uint32)a.pathNext;
+		return r;
+	}
+
+	Actor FromRecord(const SnapshotActor& r, const Vec2* path) {
+		Actor a;
+		a.pos = r.pos; a.lastPos = r.lastPos; a.prevPos = r.prevPos;
+		if (r.hasMoveTarget) a.moveTarget = r.moveTarget;
+		a.radius = r.radius; a.speed = r.speed; a.hp = r.hp;
+		a.life = r.life; a.age = r.age;
+		a.alive = (r.alive != 0);
+		a.path.assign(path, path + r.pathCount);
+		a.pathNext = r.pathNext;
+		return a;
+	}
+
+	template <class Pool>
+	size_t ColumnBytes(const Pool& pool, size_t n) {
+		size_t bytes = 0;
+		pool.forEachColumn([&](const auto& col) { bytes += n * sizeof(col[0]); });
+		return bytes;
+	}
+}
+
+void WriteSnapshot(const SimCore& sim, Phase phase, Array<uint8>& out) {
+	const Board& brd = sim.brd;
+
+	SnapshotHeader h;
+	h.width = brd.w; h.height = brd.h;
+	h.stage = sim.stage;
+	h.phase = (int32)phase;
+	h.moneyBlue = sim.moneyBlue; h.moneyRed = sim.moneyRed;
+	h.turnCount = sim.turnCount;
+	h.blueHQ = sim.blueHQ.value; h.redHQ = sim.redHQ.value;
+	h.simTime = sim.simTime; h.simElapsed = sim.simElapsed;
+	h.seed = sim.seed;
+	std::memcpy(h.rng, &sim.rng, sizeof(sim.rng));
+	h.tileCount = (uint32)brd.tileCount();
+	h.structureCount = (uint32)sim.structures.dense().size();
+	h.structureSlotCount = (uint32)sim.structures.slots().size();
+	h.structureFreeCount = (uint32)sim.structures.freeSlots().size();
+	h.hasPlayer = (sim.player ? 1 : 0);
+	h.actorCount = (uint32)(h.hasPlayer + sim.redAgents.size());
+	size_t pathPoints = (sim.player ? sim.player->path.size() : 0);
+	for (const auto& a : sim.redAgents) pathPoints += a.path.size();
+	h.pathPointCount = (uint32)pathPoints;
+	h.straightCount = (uint32)sim.projectiles.straight.size();
+	h.arcCount = (uint32)sim.projectiles.arcs.size();
+	h.placeableBlue = (uint32)sim.placement.cells(Team::Blue).size();
+	h.placeableRed = (uint32)sim.placement.cells(Team::Red).size();
+
+	out.clear();
+	out.reserve(sizeof(h) + h.tileCount * (sizeof(TileKind) + sizeof(PaintValue) + 2 * sizeof(StructureHandle))
+		+ h.structureCount * sizeof(Structure) + h.structureSlotCount * sizeof(StructureMap::Slot) + h.structureFreeCount * sizeof(uint32)
+		+ h.actorCount * sizeof(SnapshotActor) + h.pathPointCount * sizeof(Vec2)
+		+ ColumnBytes(sim.projectiles.straight, h.straightCount) + ColumnBytes(sim.projectiles.arcs, h.arcCount)
+		+ (h.placeableBlue + h.placeableRed) * sizeof(int32));
+
+	Append(out, &h, sizeof(h));
+	AppendArray(out, brd.kind);
+	AppendArray(out, brd.paint);
+	AppendArray(out, brd.blueIndex);
+	AppendArray(out, brd.redIndex);
+	AppendArray(out, sim.structures.dense());
+	AppendArray(out, sim.structures.slots());
+	AppendArray(out, sim.structures.freeSlots());
+
+	if (sim.player) {
+		const SnapshotActor r = ToRecord(*sim.player);
+		Append(out, &r, sizeof(r));
+	}
+	for (const auto& a : sim.redAgents) {
+		const SnapshotActor r = ToRecord(a);
+		Append(out, &r, sizeof(r));
+	}
+	if (sim.player) AppendArray(out, sim.player->path);
+	for (const auto& a : sim.redAgents) AppendArray(out, a.path);
+
+	sim.projectiles.straight.forEachColumn([&](const auto& col) { AppendArray(out, col); });
+	sim.projectiles.arcs.forEachColumn([&](const auto& col) { AppendArray(out, col); });
+
+	AppendArray(out, sim.placement.cells(Team::Blue));
+	AppendArray(out, sim.placement.cells(Team::Red));
+}
+
+Array<uint8> WriteSnapshot(const SimCore& sim, Phase phase) {
+	Array<uint8> out;
+	WriteSnapshot(sim, phase, out);
+	return out;
+}
+
+bool ReadSnapshot(SimCore& sim, const uint8* data, size_t size, Phase* phase) {
+	if (!data || size < sizeof(SnapshotHeader)) return false;
+
+	SnapshotHeader h;
+	std::memcpy(&h, data, sizeof(h));
+	if (h.magic != SnapshotMagic || h.version != SnapshotVersion) return false;
+	if (h.chunkShift != BoardChunkShift || h.paintBits != INKWARS_PAINT_BITS) return false;
+	if (h.width <= 0 || h.height <= 0) return false;
+	if (h.phase < (int32)Phase::Planning || h.phase >(int32)Phase::Summary) return false;
+
+	const size_t chunksX = (((size_t)h.width + BoardChunkSize - 1) >> BoardChunkShift);
+	const size_t chunksY = (((size_t)h.height + BoardChunkSize - 1) >> BoardChunkShift);
+	if (h.tileCount != ((chunksX * chunksY) << (2 * BoardChunkShift))) return false;
+	if ((uint32)h.hasPlayer > 1 || (uint32)h.hasPlayer > h.actorCount) return false;
+
+	// 先に全部の区切りを確かめる（ここまでは sim に触らない）
+	ByteCursor cur{ data + sizeof(h), data + size };
+	const uint8* kinds = cur.take((size_t)h.tileCount * sizeof(TileKind));
+	const uint8* paint = cur.take((size_t)h.tileCount * sizeof(PaintValue));
+	const uint8* blueIndex = cur.take((size_t)h.tileCount * sizeof(StructureHandle));
+	const uint8* redIndex = cur.take((size_t)h.tileCount * sizeof(StructureHandle));
+	const uint8* structureDense = cur.take((size_t)h.structureCount * sizeof(Structure));
+	const uint8* structureSlots = cur.take((size_t)h.structureSlotCount * sizeof(StructureMap::Slot));
+	const uint8* structureFree = cur.take((size_t)h.structureFreeCount * sizeof(uint32));
+	const uint8* actors = cur.take((size_t)h.actorCount * sizeof(SnapshotActor));
+	const uint8* pathPoints = cur.take((size_t)h.pathPointCount * sizeof(Vec2));
+	const uint8* straight = cur.take(ColumnBytes(sim.projectiles.straight, h.straightCount));
+	const uint8* arcs = cur.take(ColumnBytes(sim.projectiles.arcs, h.arcCount));
+	const uint8* placeBlue = cur.take((size_t)h.placeableBlue * sizeof(int32));
+	const uint8* placeRed = cur.take((size_t)h.placeableRed * sizeof(int32));
+	if (!cur.ok) return false;
+
+	Array<SnapshotActor> records;
+	CopyTo(records, actors, h.actorCount);
+	uint64 pathTotal = 0;
+	for (const auto& r : records) {
+		if (r.pathNext > r.pathCount) return false;
+		pathTotal += r.pathCount;
+	}
+	if (pathTotal != h.pathPointCount) return false;
+
+	// 構造物を組み直し、盤面のハンドルがすべてその側の生きた構造物を指しているか確かめる
+	StructureMap structures;
+	{
+		Array<Structure> dense;
+		Array<StructureMap::Slot> slots;
+		Array<uint32> free; // 整列していないかもしれないので写してから使う
+		CopyTo(dense, structureDense, h.structureCount);
+		CopyTo(slots, structureSlots, h.structureSlotCount);
+		CopyTo(free, structureFree, h.structureFreeCount);
+		if (!structures.restore(dense.data(), dense.size(), slots.data(), slots.size(), free.data(), free.size())) return false;
+	}
+	for (const auto& [src, owner] : { std::pair{ blueIndex, Team::Blue }, std::pair{ redIndex, Team::Red } }) {
+		for (uint32 i = 0; i < h.tileCount; ++i) {
+			StructureHandle v;
+			std::memcpy(&v, src + i * sizeof(StructureHandle), sizeof(StructureHandle));
+			if (!v) continue;
+			const Structure* s = structures.get(v);
+			if (!s || s->owner != owner) return false;
+		}
+	}
+	// 逆向き：どの構造物も盤面の中にいて、その側の盤面のハンドルがその構造物を指しているか
+	for (size_t k = 0; k < structures.size(); ++k) {
+		const Structure& s = structures.dense()[k];
+		if (s.owner != Team::Blue && s.owner != Team::Red) return false;
+		if (s.cell.x < 0 || s.cell.y < 0 || s.cell.x >= h.width || s.cell.y >= h.height) return false;
+		const size_t chunk = ((size_t)(s.cell.y >> BoardChunkShift) * chunksX + (size_t)(s.cell.x >> BoardChunkShift));
+		const size_t i = ((chunk << (2 * BoardChunkShift)) | (size_t)(((s.cell.y & (BoardChunkSize - 1)) << BoardChunkShift) | (s.cell.x & (BoardChunkSize - 1))));
+		StructureHandle v;
+		std::memcpy(&v, (s.owner == Team::Blue ? blueIndex : redIndex) + i * sizeof(StructureHandle), sizeof(StructureHandle));
+		if (v != structures.handleAt(k)) return false;
+	}
+	// 地形の種類
+	for (uint32 i = 0; i < h.tileCount; ++i) {
+		if (kinds[i] > (uint8)TileKind::HQRed) return false;
+	}
+
+	// ---- ここから書き込み ----
+	Board& brd = sim.brd;
+	brd.init(h.width, h.height);
+	std::memcpy(brd.kind.data(), kinds, (size_t)h.tileCount * sizeof(TileKind));
+	std::memcpy(brd.paint.data(), paint, (size_t)h.tileCount * sizeof(PaintValue));
+	std::memcpy(brd.blueIndex.data(), blueIndex, (size_t)h.tileCount * sizeof(StructureHandle));
+	std::memcpy(brd.redIndex.data(), redIndex, (size_t)h.tileCount * sizeof(StructureHandle));
+	brd.recountOwnership();
+
+	sim.structures = std::move(structures);
+	sim.blueHQ = StructureHandle{ h.blueHQ };
+	sim.redHQ = StructureHandle{ h.redHQ };
+
+	Array<Vec2> pathBuf;
+	CopyTo(pathBuf, pathPoints, h.pathPointCount); // 整列していないかもしれないので写してから使う
+	const Vec2* path = pathBuf.data();
+	sim.player.reset();
+	sim.redAgents.clear();
+	for (uint32 k = 0; k < h.actorCount; ++k) {
+		const Actor a = FromRecord(records[k], path);
+		path += records[k].pathCount;
+		if (k == 0 && h.hasPlayer) sim.player = a;
+		else sim.redAgents << a;
+	}
+
+	sim.projectiles.straight.forEachColumn([&](auto& col) {
+		CopyTo(col, straight, h.straightCount);
+		straight += col.size() * sizeof(col[0]);
+		});
+	sim.projectiles.arcs.forEachColumn([&](auto& col) {
+		CopyTo(col, arcs, h.arcCount);
+		arcs += col.size() * sizeof(col[0]);
+		});
+
+	sim.stage = h.stage;
+	sim.moneyBlue = h.moneyBlue;
+	sim.moneyRed = h.moneyRed;
+	sim.turnCount = h.turnCount;
+	sim.simTime = h.simTime;
+	sim.simElapsed = h.simElapsed;
+	sim.seed = h.seed;
+	std::memcpy(&sim.rng, h.rng, sizeof(sim.rng));
+
+	// キャッシュは作り直す（射線・経路は Board::init で wallVersion が変わったので次に使うときに作られる）
+	sim.targets.rebuild(brd);
+	{
+		Array<int32> blue, red; // 整列していないかもしれないので写してから使う
+		CopyTo(blue, placeBlue, h.placeableBlue);
+		CopyTo(red, placeRed, h.placeableRed);
+		if (!sim.placement.restore(brd, blue.data(), blue.size(), red.data(), red.size())) sim.placement.rebuild(brd);
+	}
+	sim.flowDirty = true;
+	sim.events.clear();
+
+	if (phase) *phase = (Phase)h.phase;
+	return true;
+}
+
+bool SaveSnapshotFile(FilePathView path, const SimCore& sim, Phase phase) {
+	const Array<uint8> bytes = WriteSnapshot(sim, phase);
+	BinaryWriter writer{ path };
+	if (!writer) return false;
+	writer.write(bytes.data(), bytes.size());
+	return true;
+}
+
+bool LoadSnapshotFile(FilePathView path, SimCore& sim, Phase* phase) {
+	MemoryMappedFileView file{ path };
+	if (!file) return false;
+	const auto mapped = file.mapAll();
+	return ReadSnapshot(sim, reinterpret_cast<const uint8*>(mapped.data), mapped.size, phase);
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Config.h"
+#include "Types.h"
+#include "SimCore.h"
+
+// ===================== スナップショット（.iwsave） =====================
+// SimCore の試合状態をそのまま並べたバイナリ。セーブデータにも、メモリ上での分岐・巻き戻し
+// （AI の先読み・リプレイのシーク）にも使う。
+//   [SnapshotHeader][地形][塗り][blueIndex][redIndex][構造物][構造物のスロット][空きスロット][ユニット][経路点][実弾の各列][設置可能セル]
+//   地形・塗り・インデックス・構造物・実弾は配列をそのまま memcpy する（1要素ずつの変換はしない）。
+//   塗りはビルドのビット数（INKWARS_PAINT_BITS）のまま書くので、ビット数の違うビルドのものは読まない。
+//   構造物は StructureMap の中身（並び・スロットの世代・空きスロット）ごと書くので、読み込み後もハンドルはそのまま使える。
+//   ターゲット索引・射線・経路・誘導場のキャッシュは書かず、読み込み後に作り直す。
+//   設置可能セルの並びは乱数での抽選結果に効くので、キャッシュでも順番どおりに書く。
+// 演出イベント・redAI・eventsEnabled は実行時の設定なので含めない（読み込み先のものをそのまま使う）。
+// 地形・塗り / Structure / 実弾の型や BoardChunkShift を変えたら SnapshotVersion を上げること。
+inline constexpr uint32 SnapshotMagic = 0x56535749; // "IWSV"
+inline constexpr uint32 SnapshotVersion = 3;
+
+struct SnapshotHeader {
+	uint32 magic = SnapshotMagic;
+	uint32 version = SnapshotVersion;
+	int32 width = 0, height = 0;
+	int32 chunkShift = BoardChunkShift;
+	int32 stage = 1;
+	int32 phase = 0;		// Phase（Game 側のフェーズ）
+	int32 moneyBlue = 0, moneyRed = 0;
+	int32 turnCount = 1;
+	uint32 blueHQ = 0, redHQ = 0;	// StructureHandle::value
+	double simTime = 0.0, simElapsed = 0.0;
+	uint64 seed = 0;
+	uint8 rng[32] = {};		// SmallRNG の内部状態
+	uint32 tileCount = 0;
+	int32 paintBits = INKWARS_PAINT_BITS;
+	uint32 structureCount = 0, structureSlotCount = 0, structureFreeCount = 0;
+	uint32 actorCount = 0;	// プレイヤー（いれば先頭）+ 敵ユニット
+	int32 hasPlayer = 0;
+	uint32 pathPointCount = 0;
+	uint32 straightCount = 0, arcCount = 0;
+	uint32 placeableBlue = 0, placeableRed = 0;
+};
+
+// 歩行ユニット（Actor のうち経路以外。経路は全ユニットぶんを続けて後ろに置く）
+struct SnapshotActor {
+	s3d::Vec2 pos, lastPos, prevPos;
+	s3d::Vec2 moveTarget;
+	double radius = 0.0, speed = 0.0, hp = 0.0;
+	double life = 0.0, age = 0.0;
+	int32 alive = 0;
+	int32 hasMoveTarget = 0;
+	uint32 pathCount = 0;
+	uint32 pathNext = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>&& std::is_trivially_copyable_v<SnapshotActor>);
+static_assert(std::is_trivially_copyable_v<Structure>&& std::is_trivially_copyable_v<StructureMap::Slot>&& sizeof(StructureHandle) == sizeof(uint32));
+static_assert(std::is_trivially_copyable_v<s3d::SmallRNG> && sizeof(s3d::SmallRNG) <= sizeof(SnapshotHeader::rng));
+
+// sim の状態を out に書く（out の容量は使い回す）
+void WriteSnapshot(const SimCore& sim, Phase phase, s3d::Array<uint8>& out);
+s3d::Array<uint8> WriteSnapshot(const SimCore& sim, Phase phase = Phase::Planning);
+
+// スナップショットから sim を復元する（壊れていれば false で sim は変えない）。phase には書いたときのフェーズが入る
+bool ReadSnapshot(SimCore& sim, const uint8* data, size_t size, Phase* phase = nullptr);
+
+// ファイルへの保存・読み込み
+bool SaveSnapshotFile(s3d::FilePathView path, const SimCore& sim, Phase phase);
+bool LoadSnapshotFile(s3d::FilePathView path, SimCore& sim, Phase* phase = nullptr);
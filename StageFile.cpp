@@ -0,0 +1,135 @@
+﻿#include "StageFile.h"
+#include "map.h"
+#include "RomPath.h"
+
+using namespace s3d;
+
+Optional<StageView> ParseStage(const uint8* data, size_t size) {
+	if (!data || size < sizeof(StageFileHeader)) return none;
+
+	const auto* h = reinterpret_cast<const StageFileHeader*>(data);
+	if (h->magic != StageFileMagic || h->version != StageFileVersion) return none;
+	if (h->chunkShift != BoardChunkShift) return none;
+	if (h->width <= 0 || h->height <= 0 || h->structureCount < 0) return none;
+
+	const size_t chunksX = (((size_t)h->width + BoardChunkSize - 1) >> BoardChunkShift);
+	const size_t chunksY = (((size_t)h->height + BoardChunkSize - 1) >> BoardChunkShift);
+	if (h->tileCount != ((chunksX * chunksY) << (2 * BoardChunkShift))) return none;
+
+	const size_t structEnd = (size_t)h->structureOffset + (size_t)h->structureCount * sizeof(StageFileStructure);
+	const size_t kindEnd = (size_t)h->kindOffset + (size_t)h->tileCount * sizeof(TileKind);
+	const size_t paintEnd = (size_t)h->paintOffset + (size_t)h->tileCount * sizeof(StagePaint);
+	if (structEnd > size || kindEnd > size || paintEnd > size) return none;
+	if ((h->structureOffset % alignof(StageFileStructure)) != 0 || (h->paintOffset % alignof(StagePaint)) != 0) return none;
+
+	StageView v;
+	v.header = h;
+	v.structures = reinterpret_cast<const StageFileStructure*>(data + h->structureOffset);
+	v.kinds = reinterpret_cast<const TileKind*>(data + h->kindOffset);
+	v.paint = reinterpret_cast<const StagePaint*>(data + h->paintOffset);
+	return v;
+}
+
+void CopyStageTiles(const StageView& view, TileKind* kinds, PaintValue* paint) {
+	const size_t n = view.header->tileCount;
+	std::memcpy(kinds, view.kinds, n * sizeof(TileKind));
+	if constexpr (std::is_same_v<PaintValue, StagePaint>) {
+		std::memcpy(paint, view.paint, n * sizeof(StagePaint));
+	}
+	else {
+		for (size_t i = 0; i < n; ++i) paint[i] = PaintFromStage(view.paint[i]);
+	}
+}
+
+FilePath StageFilePath(int stageNo) {
+	// テクスチャ・音声と同じ Rom の下（RomRoot）
+	return RomPath(U"stages/stage{}.iwstage"_fmt(stageNo));
+}
+
+// ===================== 変換 =====================
+Array<uint8> EncodeStageGrid(const Array<String>& rows, int32 moneyBlue, int32 moneyRed) {
+	StageFileHeader h;
+	h.height = (int32)rows.size();
+	for (const auto& row : rows) h.width = Max(h.width, (int32)row.size());
+	h.moneyBlue = moneyBlue;
+	h.moneyRed = moneyRed;
+
+	const int chunksX = ((h.width + BoardChunkSize - 1) >> BoardChunkShift);
+	const int chunksY = ((h.height + BoardChunkSize - 1) >> BoardChunkShift);
+	const size_t tileCount = (((size_t)chunksX * chunksY) << (2 * BoardChunkShift));
+	Array<TileKind> kinds(tileCount, TileKind::Floor);
+	Array<StagePaint> paint(tileCount, StagePaintFromUnit(0.50));
+	Array<StageFileStructure> structures;
+
+	for (int y = 0; y < h.height; ++y) {
+		for (int x = 0; x < h.width; ++x) {
+			const int chunk = ((y >> BoardChunkShift) * chunksX + (x >> BoardChunkShift));
+			const int local = (((y & (BoardChunkSize - 1)) << BoardChunkShift) | (x & (BoardChunkSize - 1)));
+			const size_t i = (((size_t)chunk << (2 * BoardChunkShift)) | local);
+			TileKind& kind = kinds[i];
+			StagePaint& p = paint[i];
+
+			const char32 ch = (x < (int)rows[y].size() ? rows[y][x] : U'.');
+
+			auto placeRed = [&](StructureType type) {
+				structures << StageFileStructure{ (int32)Team::Red, (int32)type, x, y };
+				p = StagePaintFromUnit(0.20);
+				};
+
+			switch (ch) {
+			case U'0': kind = TileKind::Wall; break;
+			case U'P': kind = TileKind::HQBlue; p = StagePaintFromUnit(1.0); h.blueHQX = x; h.blueHQY = y; break; //自軍HQ
+			case U'E': kind = TileKind::HQRed;  p = StagePaintFromUnit(0.0); h.redHQX = x; h.redHQY = y; break;   //敵軍HQ
+			case U'r': p = StagePaintFromUnit(0.20); break;
+			case U'b': p = StagePaintFromUnit(0.80); break;
+			case U't': placeRed(StructureType::Basic); break;
+			case U's': placeRed(StructureType::Sprinkler); break;
+			case U'p': placeRed(StructureType::Pump); break;
+			case U'm': placeRed(StructureType::Mortar); break;
+			case U'n': placeRed(StructureType::Sniper); break;
+			default: break;
+			}
+		}
+	}
+
+	h.structureCount = (int32)structures.size();
+	h.structureOffset = sizeof(StageFileHeader);
+	h.kindOffset = (uint32)(h.structureOffset + structures.size() * sizeof(StageFileStructure));
+	h.paintOffset = (uint32)(h.kindOffset + tileCount * sizeof(TileKind)); // タイル数はチャンク（256）の倍数なので揃っている
+	h.tileCount = (uint32)tileCount;
+
+	Array<uint8> out(h.paintOffset + tileCount * sizeof(StagePaint));
+	std::memcpy(out.data(), &h, sizeof(h));
+	if (!structures.isEmpty()) std::memcpy(out.data() + h.structureOffset, structures.data(), structures.size() * sizeof(StageFileStructure));
+	std::memcpy(out.data() + h.kindOffset, kinds.data(), tileCount * sizeof(TileKind));
+	std::memcpy(out.data() + h.paintOffset, paint.data(), tileCount * sizeof(StagePaint));
+	return out;
+}
+
+Array<uint8> EncodeBuiltinStage(int stageNo) {
+	const char(*grid)[GW] = (stageNo == 1 ? MapTip_Stage1 : (stageNo == 2 ? MapTip_Stage2 : MapTip_Stage3));
+	Array<String> rows(GH);
+	// 行の文字列は GW - 1 文字。残りの '\0' も床として GW 列ぶん読む（盤面は GW x GH）
+	for (int y = 0; y < GH; ++y) {
+		for (int x = 0; x < GW; ++x) rows[y] << (grid[y][x] != '\0' ? (char32)grid[y][x] : U'.');
+	}
+	return EncodeStageGrid(rows, DefaultStageMoneyBlue(stageNo), DefaultStageMoneyRed(stageNo));
+}
+
+Array<String> LoadStageGridText(FilePathView path) {
+	Array<String> rows;
+	TextReader reader{ path };
+	if (!reader) return rows;
+
+	String line;
+	while (reader.readLine(line)) {
+		if (line.includes(U'{') || line.includes(U'}')) continue; // 配列の宣言行
+		String row;
+		for (const char32 ch : line) {
+			if (ch == U'"' || ch == U',' || ch == U' ' || ch == U'\t' || ch == U'\r') continue;
+			row << ch;
+		}
+		if (!row.isEmpty()) rows << row;
+	}
+	return rows;
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Config.h"
+#include "Types.h"
+#include "Entities.h"
+
+// ===================== ステージファイル（.iwstage） =====================
+// [StageFileHeader][StageFileStructure × structureCount][TileKind × tileCount][StagePaint × tileCount]
+//   地形と塗りは Board と同じチャンク順（BoardChunkShift）の配列なので、
+//   読み込みは Board::kind / paint へそのまま memcpy するだけ（1タイルずつの解釈はしない）。
+//   塗りはビルドの設定（INKWARS_PAINT_BITS）によらず 16bit で持つ。8bit のビルドだけ読み込み時に詰め直す。
+//   数値はリトルエンディアン。タイルの型や チャンクの大きさを変えたら StageFileVersion を上げること。
+inline constexpr uint32 StageFileMagic = 0x54535749; // "IWST"
+inline constexpr uint32 StageFileVersion = 2;
+
+// ファイル上の塗り（0=Red、65535=Blue）
+using StagePaint = uint16;
+constexpr StagePaint StagePaintFromUnit(double v) {
+	return (StagePaint)(v <= 0.0 ? 0 : (v >= 1.0 ? 0xFFFF : (int32)(v * 0xFFFF + 0.5)));
+}
+// ファイル上の塗り -> 盤面の塗り（16bit のビルドではそのまま）
+constexpr PaintValue PaintFromStage(StagePaint v) {
+	return (PaintValue)(((uint32)v * PaintMax + 0x7FFF) / 0xFFFF);
+}
+
+struct StageFileHeader {
+	uint32 magic = StageFileMagic;
+	uint32 version = StageFileVersion;
+	int32 width = 0, height = 0;
+	int32 chunkShift = BoardChunkShift;
+	int32 moneyBlue = 0, moneyRed = 0;
+	int32 blueHQX = -1, blueHQY = -1;
+	int32 redHQX = -1, redHQY = -1;
+	int32 structureCount = 0;
+	uint32 structureOffset = 0;	// ファイル先頭からのバイト位置
+	uint32 kindOffset = 0;
+	uint32 paintOffset = 0;
+	uint32 tileCount = 0;		// チャンクの余りを含む
+};
+
+// 初期配置の構造物（HQ 以外）
+struct StageFileStructure {
+	int32 owner = 0;	// Team
+	int32 type = 0;		// StructureType
+	int32 x = 0, y = 0;
+};
+
+static_assert(sizeof(StageFileHeader) == 64);
+static_assert(sizeof(StageFileStructure) == 16);
+static_assert(sizeof(TileKind) == 1);
+
+// 読み込み済みのステージ（ヘッダと構造物・タイルはマップしたメモリを指す）
+struct StageView {
+	const StageFileHeader* header = nullptr;
+	const StageFileStructure* structures = nullptr;
+	const TileKind* kinds = nullptr;
+	const StagePaint* paint = nullptr;
+};
+
+// 読み込み済みのステージの地形・塗りを盤面の配列（tileCount 要素）へ写す
+void CopyStageTiles(const StageView& view, TileKind* kinds, PaintValue* paint);
+
+// メモリ上のステージを検証して StageView を作る（壊れていれば none）
+s3d::Optional<StageView> ParseStage(const uint8* data, size_t size);
+
+// ステージファイルの置き場所（Rom/stages/stageN.iwstage）
+s3d::FilePath StageFilePath(int stageNo);
+
+// ===================== 変換（文字グリッド -> .iwstage） =====================
+// map.cpp と同じ記号：
+//   '0' 壁 / 'P' Blue HQ / 'E' Red HQ / 'r' 赤塗り / 'b' 青塗り / それ以外 中立
+//   Red 構造物：'t' 基本タレット / 's' スプリンクラー / 'p' インクポンプ / 'm' 迫撃砲 / 'n' スナイパー
+// 行の長さが揃っていなければ一番長い行に合わせ、足りない分は中立の床にする。
+s3d::Array<uint8> EncodeStageGrid(const s3d::Array<s3d::String>& rows, int32 moneyBlue, int32 moneyRed);
+
+// 組み込みステージ（MapTip_Stage*。4以降は Stage3）を .iwstage の中身にする
+s3d::Array<uint8> EncodeBuiltinStage(int stageNo);
+
+// テキスト（1行 = 1列のセル。map.cpp の行をそのまま貼ってもよい：引用符とカンマは無視）を読む
+s3d::Array<s3d::String> LoadStageGridText(s3d::FilePathView path);
+
+// ステージの初期資金（組み込みステージ・変換時の既定値）
+inline int32 DefaultStageMoneyBlue(int stageNo) { return 120 + 20 * (stageNo - 1); }
+inline int32 DefaultStageMoneyRed(int stageNo) { return 140 + 40 * (stageNo - 1); }
@@ -0,0 +1,129 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include "Entities.h"
+
+// ===================== 構造物（両チーム共通の世代付きスロットマップ） =====================
+// dense … 生きている構造物だけを詰めた配列（ループはここだけを回す。並びは erase で変わる）
+// slots … ハンドルのスロット番号 -> dense の位置と世代
+// free  … 空いたスロット（後から空いたものから使う）
+// 盤面（Board::blueIndex / redIndex）はハンドルを持つ。乗っ取りは owner を書き換えるだけなのでハンドルはそのまま使える。
+// 壊したらスロットの世代が上がるので、持っていた古いハンドルは contains / get で見分けられる。
+// erase は dense の末尾を空いた位置へ移すので、dense を回している最中に erase しないこと。
+class StructureMap {
+public:
+	static constexpr uint32 FreeSlot = 0xFFFFFFFFu;
+
+	struct Slot {
+		uint32 dense = FreeSlot;	// dense の位置（空きなら FreeSlot）
+		uint32 generation = 0;		// 最後に割り当てたときの世代
+	};
+
+	// 追加して新しいハンドルを返す（スロットを使い切っていれば「なし」）
+	StructureHandle insert(const Structure& s) {
+		uint32 slot;
+		if (!m_free.isEmpty()) {
+			slot = m_free.back();
+			m_free.pop_back();
+		}
+		else {
+			if (m_slots.size() > StructureHandle::SlotMask) return StructureHandle{};
+			slot = (uint32)m_slots.size();
+			m_slots << Slot{};
+		}
+
+		Slot& e = m_slots[slot];
+		e.generation = ((e.generation % StructureHandle::MaxGeneration) + 1);
+		e.dense = (uint32)m_dense.size();
+		m_dense << s;
+		m_denseSlot << slot;
+		return StructureHandle::Make(slot, e.generation);
+	}
+
+	// 取り除く（古いハンドルなら何もしない）
+	bool erase(StructureHandle h) {
+		if (!contains(h)) return false;
+		Slot& e = m_slots[h.slot()];
+		const uint32 at = e.dense;
+		const uint32 last = (uint32)(m_dense.size() - 1);
+		if (at != last) {
+			m_dense[at] = m_dense[last];
+			m_denseSlot[at] = m_denseSlot[last];
+			m_slots[m_denseSlot[at]].dense = at;
+		}
+		m_dense.pop_back();
+		m_denseSlot.pop_back();
+		e.dense = FreeSlot;
+		m_free << h.slot();
+		return true;
+	}
+
+	bool contains(StructureHandle h) const noexcept {
+		if (!h || h.slot() >= m_slots.size()) return false;
+		const Slot& e = m_slots[h.slot()];
+		return (e.dense != FreeSlot && e.generation == h.generation());
+	}
+
+	Structure* get(StructureHandle h) noexcept { return (contains(h) ? &m_dense[m_slots[h.slot()].dense] : nullptr); }
+	const Structure* get(StructureHandle h) const noexcept { return (contains(h) ? &m_dense[m_slots[h.slot()].dense] : nullptr); }
+
+	// dense の i 番目のハンドル
+	StructureHandle handleAt(size_t i) const noexcept {
+		const uint32 slot = m_denseSlot[i];
+		return StructureHandle::Make(slot, m_slots[slot].generation);
+	}
+
+	size_t size() const noexcept { return m_dense.size(); }
+	bool isEmpty() const noexcept { return m_dense.isEmpty(); }
+
+	auto begin() noexcept { return m_dense.begin(); }
+	auto end() noexcept { return m_dense.end(); }
+	auto begin() const noexcept { return m_dense.begin(); }
+	auto end() const noexcept { return m_dense.end(); }
+
+	void clear() {
+		m_dense.clear();
+		m_denseSlot.clear();
+		m_slots.clear();
+		m_free.clear();
+	}
+
+	// スナップショット用（中身をそのまま書き出す）
+	const s3d::Array<Structure>& dense() const noexcept { return m_dense; }
+	const s3d::Array<Slot>& slots() const noexcept { return m_slots; }
+	const s3d::Array<uint32>& freeSlots() const noexcept { return m_free; }
+
+	// 書き出した中身から作り直す。食い違っていれば false（そのときは中身を空にする）
+	bool restore(const Structure* dense, size_t denseCount, const Slot* slots, size_t slotCount, const uint32* free, size_t freeCount) {
+		clear();
+		if (slotCount > ((size_t)StructureHandle::SlotMask + 1) || (denseCount + freeCount) != slotCount) return false;
+
+		m_dense.assign(dense, dense + denseCount);
+		m_slots.assign(slots, slots + slotCount);
+		m_free.assign(free, free + freeCount);
+		m_denseSlot.assign(denseCount, FreeSlot);
+
+		bool ok = true;
+		for (uint32 slot = 0; slot < slotCount && ok; ++slot) {
+			const Slot& e = m_slots[slot];
+			if (e.dense == FreeSlot) continue;
+			ok = (e.dense < denseCount && m_denseSlot[e.dense] == FreeSlot && e.generation != 0 && e.generation <= StructureHandle::MaxGeneration);
+			if (ok) m_denseSlot[e.dense] = slot;
+		}
+		// dense が全部どこかのスロットから指されていれば、空きスロットはちょうど freeCount 個
+		for (size_t i = 0; i < denseCount && ok; ++i) ok = (m_denseSlot[i] != FreeSlot);
+		// あとは free がその空きスロットを重複なく並べたものか
+		s3d::Array<uint8> seen(slotCount, 0);
+		for (size_t k = 0; k < freeCount && ok; ++k) {
+			ok = (m_free[k] < slotCount && m_slots[m_free[k]].dense == FreeSlot && seen[m_free[k]]++ == 0);
+		}
+
+		if (!ok) clear();
+		return ok;
+	}
+
+private:
+	s3d::Array<Structure> m_dense;
+	s3d::Array<uint32> m_denseSlot;	// dense の位置 -> スロット番号
+	s3d::Array<Slot> m_slots;
+	s3d::Array<uint32> m_free;
+};
@@ -0,0 +1,140 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include <bit>
+#include "Types.h"
+#include "Board.h"
+#include "LineOfSight.h"
+
+// ===================== 射撃ターゲット索引 =====================
+// 盤面の各行を 64bit 単位のビット列で持つ
+struct CellBits {
+	int w = 0, h = 0;
+	int rowWords = 0;
+	s3d::Array<uint64> words;
+
+	void reset(int width, int height) {
+		w = width; h = height;
+		rowWords = ((w + 63) / 64);
+		words.assign((size_t)rowWords * h, 0);
+	}
+	void set(int x, int y, bool on) {
+		uint64& word = words[(size_t)y * rowWords + (x >> 6)];
+		const uint64 bit = (uint64{ 1 } << (x & 63));
+		word = (on ? (word | bit) : (word & ~bit));
+	}
+	bool test(int x, int y) const {
+		return ((words[(size_t)y * rowWords + (x >> 6)] >> (x & 63)) & 1);
+	}
+	uint64 word(int y, int j) const { return words[(size_t)y * rowWords + j]; }
+
+	// 行 y の [x0, x1] に入るビット（64bit 語 j ぶん）
+	uint64 span(int y, int j, int x0, int x1) const {
+		const int lo = s3d::Max(x0 - j * 64, 0);
+		const int hi = s3d::Min(x1 - j * 64, 63);
+		if (lo > hi) return 0;
+		const uint64 mask = ((hi == 63) ? ~uint64{ 0 } : ((uint64{ 1 } << (hi + 1)) - 1)) & ~((uint64{ 1 } << lo) - 1);
+		return (word(y, j) & mask);
+	}
+};
+
+// 砲台の射撃候補をビット列で持ち、射程の円との AND を数えて乱数で1つ選ぶ（確保なし）
+//   enemyish[atk] … atk から見て敵色のタイル（塗りが変わるたびに同期）
+//   occupied[atk] … atk から見て敵構造物のあるセル（構造物インデックスの更新時に同期）
+//   open          … 壁以外のセル（候補が1つもないときの撃ち先）
+class TargetIndex {
+public:
+	// 盤面から作り直す（マップ生成後に呼ぶ）
+	void rebuild(const Board& brd) {
+		for (int t = 0; t < 2; ++t) {
+			m_enemyish[t].reset(brd.w, brd.h);
+			m_occupied[t].reset(brd.w, brd.h);
+		}
+		m_open.reset(brd.w, brd.h);
+		brd.forEachCell([&](int x, int y, int i) {
+			setPaint(s3d::Point{ x, y }, brd.paint[i]);
+			m_occupied[slot(Team::Blue)].set(x, y, (bool)brd.redIndex[i]);
+			m_occupied[slot(Team::Red)].set(x, y, (bool)brd.blueIndex[i]);
+			m_open.set(x, y, (brd.kind[i] != TileKind::Wall));
+			});
+	}
+
+	// タイルの塗りが変わった
+	void setPaint(const s3d::Point& c, PaintValue paint) {
+		m_enemyish[slot(Team::Blue)].set(c.x, c.y, (paint < PaintRedish));
+		m_enemyish[slot(Team::Red)].set(c.x, c.y, (paint > PaintBlueish));
+	}
+
+	// owner の構造物がセルに置かれた / 外れた
+	void setStructure(Team owner, const s3d::Point& c, bool present) {
+		m_occupied[slot(owner == Team::Blue ? Team::Red : Team::Blue)].set(c.x, c.y, present);
+	}
+
+	// from から射程 range（タイル距離）以内の候補を1つ選ぶ。候補がなければ壁以外から選ぶ
+	// sight を渡すと、そのビットが立っているセル（射線が通るセル）だけから選ぶ
+	s3d::Optional<s3d::Point> pick(Team atk, const s3d::Point& from, int range, bool turretOnly, s3d::SmallRNG& rng, const SightMask* sight = nullptr) {
+		const s3d::Array<int>& disc = discFor(range);
+		const CellBits& cands = (turretOnly ? m_occupied[slot(atk)] : m_enemyish[slot(atk)]);
+		if (const auto p = pickIn(cands, from, range, disc, sight, rng)) return p;
+		return pickIn(m_open, from, range, disc, sight, rng);
+	}
+
+	// atk から見て敵構造物のあるセル（AoE のダメージはここだけに当てる）
+	const CellBits& occupied(Team atk) const noexcept { return m_occupied[slot(atk)]; }
+
+private:
+	CellBits m_enemyish[2];
+	CellBits m_occupied[2];
+	CellBits m_open;
+	s3d::Array<s3d::Array<int>> m_discs; // 射程ごとの行の半幅（dy = -r..r）
+
+	static int slot(Team t) noexcept { return (t == Team::Blue ? 0 : 1); }
+
+	// 射程 r の円：dx^2 + dy^2 <= r^2 を満たす最大の |dx| を行ごとに持つ
+	const s3d::Array<int>& discFor(int r) {
+		if (r < 0) r = 0;
+		if ((int)m_discs.size() <= r) m_discs.resize(r + 1);
+		s3d::Array<int>& d = m_discs[r];
+		if (d.isEmpty()) {
+			d.resize(2 * r + 1);
+			for (int dy = -r; dy <= r; ++dy) {
+				int hw = 0;
+				while ((hw + 1) * (hw + 1) + dy * dy <= r * r) ++hw;
+				d[dy + r] = hw;
+			}
+		}
+		return d;
+	}
+
+	template <class Fn>
+	static void forEachSpan(const CellBits& bits, const s3d::Point& from, int r, const s3d::Array<int>& disc, const SightMask* sight, Fn fn) {
+		const int y0 = s3d::Max(0, from.y - r), y1 = s3d::Min(bits.h - 1, from.y + r);
+		for (int y = y0; y <= y1; ++y) {
+			const int hw = disc[y - from.y + r];
+			const int x0 = s3d::Max(0, from.x - hw), x1 = s3d::Min(bits.w - 1, from.x + hw);
+			if (x0 > x1) continue;
+			for (int j = (x0 >> 6); j <= (x1 >> 6); ++j) {
+				if (const uint64 m = (bits.span(y, j, x0, x1) & (sight ? sight->word(y, j) : ~uint64{ 0 }))) {
+					if (!fn(y, j, m)) return;
+				}
+			}
+		}
+	}
+
+	// 1回目で数え、乱数で k 番目を決めて 2回目で取り出す
+	static s3d::Optional<s3d::Point> pickIn(const CellBits& bits, const s3d::Point& from, int r, const s3d::Array<int>& disc, const SightMask* sight, s3d::SmallRNG& rng) {
+		int total = 0;
+		forEachSpan(bits, from, r, disc, sight, [&](int, int, uint64 m) { total += std::popcount(m); return true; });
+		if (total == 0) return s3d::none;
+
+		int k = s3d::Random(0, total - 1, rng);
+		s3d::Optional<s3d::Point> out;
+		forEachSpan(bits, from, r, disc, sight, [&](int y, int j, uint64 m) {
+			const int n = std::popcount(m);
+			if (k >= n) { k -= n; return true; }
+			while (k-- > 0) m &= (m - 1); // 下位から k 個落とす
+			out = s3d::Point{ j * 64 + std::countr_zero(m), y };
+			return false;
+			});
+		return out;
+	}
+};
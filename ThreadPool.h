@@ -0,0 +1,108 @@
+﻿#pragma once
+#include <Siv3D.hpp>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// ===================== スレッドプール =====================
+// 作成時にワーカーを立てておき、parallelFor で [0, n) を分担して回す（呼び出し側のスレッドも働く）。
+// parallelFor は全部終わるまで戻らない。fn は複数スレッドから同時に呼ばれるので、共有状態を書かないこと。
+class ThreadPool {
+public:
+	// workers: 呼び出し側以外のスレッド数（既定は コア数 - 1）
+	explicit ThreadPool(size_t workers = DefaultWorkers()) {
+		for (size_t i = 0; i < workers; ++i) {
+			m_threads.emplace_back([this] { workerLoop(); });
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard lock{ m_mutex };
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (auto& t : m_threads) t.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// 同時に動くスレッド数（呼び出し側を含む）
+	size_t concurrency() const noexcept { return (m_threads.size() + 1); }
+
+	template <class Fn>
+	void parallelFor(size_t n, Fn&& fn) {
+		if (n == 0) return;
+		if (m_threads.empty() || n == 1) {
+			for (size_t i = 0; i < n; ++i) fn(i);
+			return;
+		}
+
+		std::lock_guard call{ m_callMutex }; // 別スレッドからの同時呼び出しは順番に
+		const std::function<void(size_t)> job = [&fn](size_t i) { fn(i); };
+		{
+			std::lock_guard lock{ m_mutex };
+			m_job = &job;
+			m_count = n;
+			m_next = 0;
+			m_finished = 0;
+			++m_generation;
+		}
+		m_wake.notify_all();
+
+		runItems();
+
+		// 全ワーカーが抜けるまで待つ（job はこの関数のローカルなので）
+		std::unique_lock lock{ m_mutex };
+		m_idle.wait(lock, [&] { return (m_finished == m_threads.size()); });
+		m_job = nullptr;
+	}
+
+	static size_t DefaultWorkers() {
+		const size_t n = s3d::Threading::GetConcurrency();
+		return (n > 1 ? (n - 1) : 0);
+	}
+
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex, m_callMutex;
+	std::condition_variable m_wake, m_idle;
+
+	const std::function<void(size_t)>* m_job = nullptr;
+	size_t m_count = 0;
+	std::atomic<size_t> m_next{ 0 };
+	size_t m_finished = 0;
+	uint64 m_generation = 0;
+	bool m_stop = false;
+
+	void runItems() {
+		for (size_t i; (i = m_next.fetch_add(1, std::memory_order_relaxed)) < m_count;) {
+			(*m_job)(i);
+		}
+	}
+
+	void workerLoop() {
+		uint64 seen = 0;
+		for (;;) {
+			{
+				std::unique_lock lock{ m_mutex };
+				m_wake.wait(lock, [&] { return (m_stop || m_generation != seen); });
+				if (m_stop) return;
+				seen = m_generation;
+			}
+
+			runItems();
+
+			std::lock_guard lock{ m_mutex };
+			if (++m_finished == m_threads.size()) m_idle.notify_one();
+		}
+	}
+};
+
+// ゲーム全体で使い回すプール（初回呼び出しで作る）
+inline ThreadPool& SharedThreadPool() {
+	static ThreadPool pool;
+	return pool;
+}
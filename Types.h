@@ -11,7 +11,7 @@ inline s3d::ColorF TeamColor(Team t) {
 	return ColorF{ 0.85 };
 }
 enum class Phase : int32 { Planning, Simulating, Summary };
-enum class TileKind : int32 { Floor = 0, Wall = 1, HQBlue = 2, HQRed = 3 };
+enum class TileKind : uint8 { Floor = 0, Wall = 1, HQBlue = 2, HQRed = 3 };
 
 enum class StructureType : int32 {
 	Basic = 0,
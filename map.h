@@ -2,6 +2,7 @@
 using namespace s3d;
 #include "Config.h"
 
+// 組み込みステージ（記号の意味と .iwstage への変換は StageFile.h）
 
 extern char MapTip_Stage1[GH][GW];
 